@@ -0,0 +1,409 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// a small google-benchmark style harness
+//
+//   static void bm_write(yazi::bench::State & state)
+//   {
+//       for (auto _ : state) { ... }
+//       state.set_bytes_processed(state.iterations() * n);
+//   }
+//   BENCHMARK(bm_write)->arg(16)->arg(1024);
+//   BENCHMARK_MAIN();
+//
+// flags: --benchmark_filter=<regex> --benchmark_format=<console|json>
+//        --benchmark_out=<file> --benchmark_min_time=<seconds>
+//        --benchmark_repetitions=<n>
+
+namespace yazi {
+namespace bench {
+
+// counted from every thread, the threaded benches allocate on workers too
+inline std::atomic<long> & alloc_count()
+{
+    static std::atomic<long> count(0);
+    return count;
+}
+
+template <typename T>
+inline void do_not_optimize(const T & value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory()
+{
+    asm volatile("" : : : "memory");
+}
+
+class State
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(State * state, long count) : m_state(state), m_count(count) {}
+
+        int operator * () const { return 0; }
+
+        Iterator & operator ++ ()
+        {
+            --m_count;
+            return *this;
+        }
+
+        bool operator != (const Iterator &)
+        {
+            if (m_count > 0)
+            {
+                return true;
+            }
+            m_state->finish();
+            return false;
+        }
+
+    private:
+        State * m_state;
+        long m_count;
+    };
+
+    State(long iterations, const std::vector<long> & args)
+        : m_iterations(iterations), m_args(args), m_bytes(0), m_items(0), m_allocs(0), m_seconds(0) {}
+
+    long range(int index = 0) const { return m_args[index]; }
+    long iterations() const { return m_iterations; }
+    void set_bytes_processed(long bytes) { m_bytes = bytes; }
+    void set_items_processed(long items) { m_items = items; }
+    void set_label(const std::string & label) { m_label = label; }
+
+    Iterator begin()
+    {
+        m_allocs = alloc_count().load(std::memory_order_relaxed);
+        m_start = std::chrono::steady_clock::now();
+        return Iterator(this, m_iterations);
+    }
+
+    Iterator end()
+    {
+        return Iterator(this, 0);
+    }
+
+    void finish()
+    {
+        m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+        m_allocs = alloc_count().load(std::memory_order_relaxed) - m_allocs;
+    }
+
+private:
+    friend class Runner;
+
+    long m_iterations;
+    std::vector<long> m_args;
+    long m_bytes;
+    long m_items;
+    long m_allocs;
+    double m_seconds;
+    std::string m_label;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+typedef void (*Function)(State &);
+
+class Benchmark
+{
+public:
+    Benchmark(const std::string & name, Function func) : m_name(name), m_func(func) {}
+
+    Benchmark * arg(long value)
+    {
+        m_args.push_back(std::vector<long>(1, value));
+        return this;
+    }
+
+    Benchmark * args(const std::vector<long> & values)
+    {
+        m_args.push_back(values);
+        return this;
+    }
+
+private:
+    friend class Runner;
+
+    std::string m_name;
+    Function m_func;
+    std::vector<std::vector<long>> m_args;
+};
+
+inline std::vector<Benchmark *> & registry()
+{
+    static std::vector<Benchmark *> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark * register_benchmark(const std::string & name, Function func)
+{
+    registry().push_back(new Benchmark(name, func));
+    return registry().back();
+}
+
+struct Result
+{
+    std::string name;
+    std::string label;
+    long iterations;
+    double ns;
+    double bytes_per_second;
+    double items_per_second;
+    double allocs;
+};
+
+class Runner
+{
+public:
+    Runner(int argc, char * argv[]) : m_filter(".*"), m_json(false), m_min_time(0.2), m_repetitions(1)
+    {
+        m_executable = argc > 0 ? argv[0] : "";
+        for (int i = 1; i < argc; i++)
+        {
+            std::string flag = argv[i];
+            if (match(flag, "--benchmark_filter="))
+            {
+                m_filter = value(flag);
+            }
+            else if (match(flag, "--benchmark_format="))
+            {
+                m_json = value(flag) == "json";
+            }
+            else if (match(flag, "--benchmark_out="))
+            {
+                m_out = value(flag);
+            }
+            else if (match(flag, "--benchmark_min_time="))
+            {
+                m_min_time = std::atof(value(flag).c_str());
+            }
+            else if (match(flag, "--benchmark_repetitions="))
+            {
+                m_repetitions = std::max(1, std::atoi(value(flag).c_str()));
+            }
+            else
+            {
+                m_rest.push_back(flag);
+            }
+        }
+    }
+
+    const std::vector<std::string> & rest() const { return m_rest; }
+
+    int run()
+    {
+        std::regex filter(m_filter);
+        std::vector<Result> results;
+        if (!m_json)
+        {
+            std::printf("%-48s %14s %12s %14s %10s\n", "benchmark", "time/op", "iterations", "throughput", "allocs/op");
+        }
+        for (Benchmark * bm : registry())
+        {
+            std::vector<std::vector<long>> cases = bm->m_args;
+            if (cases.empty())
+            {
+                cases.push_back(std::vector<long>());
+            }
+            for (auto & args : cases)
+            {
+                std::string name = bm->m_name;
+                for (long a : args)
+                {
+                    name += "/" + std::to_string(a);
+                }
+                if (!std::regex_search(name, filter))
+                {
+                    continue;
+                }
+                std::vector<Result> runs;
+                for (int r = 0; r < m_repetitions; r++)
+                {
+                    runs.push_back(measure(bm, name, args));
+                    if (!m_json)
+                    {
+                        print(runs.back());
+                    }
+                }
+                results.insert(results.end(), runs.begin(), runs.end());
+                if (m_repetitions > 1)
+                {
+                    std::sort(runs.begin(), runs.end(), [](const Result & a, const Result & b) { return a.ns < b.ns; });
+                    Result best = runs.front();
+                    best.name += "_min";
+                    Result median = runs[runs.size() / 2];
+                    median.name += "_median";
+                    results.push_back(best);
+                    results.push_back(median);
+                    if (!m_json)
+                    {
+                        print(best);
+                        print(median);
+                    }
+                }
+            }
+        }
+        if (m_json)
+        {
+            json(stdout, results);
+        }
+        if (!m_out.empty())
+        {
+            FILE * fp = std::fopen(m_out.c_str(), "w");
+            if (fp != NULL)
+            {
+                json(fp, results);
+                std::fclose(fp);
+            }
+        }
+        return 0;
+    }
+
+private:
+    static bool match(const std::string & flag, const std::string & prefix)
+    {
+        return flag.compare(0, prefix.size(), prefix) == 0;
+    }
+
+    static std::string value(const std::string & flag)
+    {
+        return flag.substr(flag.find('=') + 1);
+    }
+
+    Result measure(Benchmark * bm, const std::string & name, const std::vector<long> & args)
+    {
+        long iterations = 1;
+        while (true)
+        {
+            State state(iterations, args);
+            bm->m_func(state);
+            if (state.m_seconds >= m_min_time || iterations >= 1000000000L)
+            {
+                Result result;
+                result.name = name;
+                result.label = state.m_label;
+                result.iterations = iterations;
+                result.ns = state.m_seconds * 1e9 / iterations;
+                result.bytes_per_second = state.m_bytes / state.m_seconds;
+                result.items_per_second = state.m_items / state.m_seconds;
+                result.allocs = (double)state.m_allocs / iterations;
+                return result;
+            }
+            double scale = state.m_seconds > 0 ? m_min_time * 1.4 / state.m_seconds : 100;
+            iterations = std::min(1000000000L, std::max(iterations + 1, (long)(iterations * std::min(scale, 100.0))));
+        }
+    }
+
+    static void print(const Result & r)
+    {
+        char throughput[32] = "";
+        if (r.bytes_per_second > 0)
+        {
+            std::snprintf(throughput, sizeof(throughput), "%.1f MB/s", r.bytes_per_second / 1e6);
+        }
+        else if (r.items_per_second > 0)
+        {
+            std::snprintf(throughput, sizeof(throughput), "%.2f M/s", r.items_per_second / 1e6);
+        }
+        std::printf("%-48s %11.1f ns %12ld %14s %10.2f %s\n",
+            r.name.c_str(), r.ns, r.iterations, throughput, r.allocs, r.label.c_str());
+    }
+
+    void json(FILE * fp, const std::vector<Result> & results) const
+    {
+        char date[64];
+        std::time_t now = std::time(NULL);
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+        std::fprintf(fp, "{\n  \"context\": {\n");
+        std::fprintf(fp, "    \"date\": \"%s\",\n", date);
+        std::fprintf(fp, "    \"executable\": \"%s\",\n", m_executable.c_str());
+        std::fprintf(fp, "    \"num_cpus\": %u\n", std::thread::hardware_concurrency());
+        std::fprintf(fp, "  },\n  \"benchmarks\": [");
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result & r = results[i];
+            std::fprintf(fp, "%s\n    {\n", i == 0 ? "" : ",");
+            std::fprintf(fp, "      \"name\": \"%s\",\n", r.name.c_str());
+            std::fprintf(fp, "      \"iterations\": %ld,\n", r.iterations);
+            std::fprintf(fp, "      \"real_time\": %.3f,\n", r.ns);
+            std::fprintf(fp, "      \"time_unit\": \"ns\",\n");
+            std::fprintf(fp, "      \"bytes_per_second\": %.1f,\n", r.bytes_per_second);
+            std::fprintf(fp, "      \"items_per_second\": %.1f,\n", r.items_per_second);
+            std::fprintf(fp, "      \"allocs_per_iter\": %.3f,\n", r.allocs);
+            std::fprintf(fp, "      \"label\": \"%s\"\n", r.label.c_str());
+            std::fprintf(fp, "    }");
+        }
+        std::fprintf(fp, "\n  ]\n}\n");
+    }
+
+private:
+    std::string m_executable;
+    std::string m_filter;
+    bool m_json;
+    std::string m_out;
+    double m_min_time;
+    int m_repetitions;
+    std::vector<std::string> m_rest;
+};
+
+}
+}
+
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_(a, b)
+
+#define BENCHMARK(func)                                                            \
+    static ::yazi::bench::Benchmark * BENCHMARK_CONCAT(bench_, __LINE__) =         \
+        ::yazi::bench::register_benchmark(#func, func)
+
+#define BENCHMARK_TEMPLATE(func, ...)                                              \
+    static ::yazi::bench::Benchmark * BENCHMARK_CONCAT(bench_, __LINE__) =         \
+        ::yazi::bench::register_benchmark(#func "<" #__VA_ARGS__ ">", func<__VA_ARGS__>)
+
+// counts every heap allocation so that results can report allocs per op
+#define BENCHMARK_ALLOC_HOOKS()                                                    \
+    void * operator new(std::size_t size)                                          \
+    {                                                                              \
+        ::yazi::bench::alloc_count().fetch_add(1, std::memory_order_relaxed);      \
+        void * p = std::malloc(size ? size : 1);                                   \
+        if (p == NULL)                                                             \
+        {                                                                          \
+            throw std::bad_alloc();                                                \
+        }                                                                          \
+        return p;                                                                  \
+    }                                                                              \
+    void * operator new[](std::size_t size)                                        \
+    {                                                                              \
+        return operator new(size);                                                 \
+    }                                                                              \
+    void operator delete(void * p) noexcept                                        \
+    {                                                                              \
+        std::free(p);                                                              \
+    }                                                                              \
+    void operator delete[](void * p) noexcept                                      \
+    {                                                                              \
+        std::free(p);                                                              \
+    }
+
+#define BENCHMARK_MAIN()                                                           \
+    BENCHMARK_ALLOC_HOOKS()                                                        \
+    int main(int argc, char * argv[])                                              \
+    {                                                                              \
+        return ::yazi::bench::Runner(argc, argv).run();                            \
+    }
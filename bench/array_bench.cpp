@@ -0,0 +1,83 @@
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+static void write_per_element(DataStream & ds, const vector<double> & value)
+{
+    char type = DataStream::VECTOR;
+    ds.write(&type, sizeof(char));
+    int len = value.size();
+    ds.write(len);
+    for (auto & item : value)
+    {
+        ds.write(item);
+    }
+}
+
+static vector<double> input(long n)
+{
+    vector<double> value(n);
+    for (long i = 0; i < n; i++)
+    {
+        value[i] = i * 0.5;
+    }
+    return value;
+}
+
+static void bm_write_packed(State & state)
+{
+    vector<double> value = input(state.range(0));
+    for (auto _ : state)
+    {
+        DataStream ds;
+        ds << value;
+    }
+    state.set_bytes_processed(state.iterations() * value.size() * sizeof(double));
+}
+BENCHMARK(bm_write_packed)->arg(16)->arg(1024)->arg(1 << 20);
+
+static void bm_write_per_element(State & state)
+{
+    vector<double> value = input(state.range(0));
+    for (auto _ : state)
+    {
+        DataStream ds;
+        write_per_element(ds, value);
+    }
+    state.set_bytes_processed(state.iterations() * value.size() * sizeof(double));
+}
+BENCHMARK(bm_write_per_element)->arg(16)->arg(1024)->arg(1 << 20);
+
+static void bm_read_packed(State & state)
+{
+    DataStream ds;
+    ds << input(state.range(0));
+    vector<double> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * output.size() * sizeof(double));
+}
+BENCHMARK(bm_read_packed)->arg(16)->arg(1024)->arg(1 << 20);
+
+static void bm_read_per_element(State & state)
+{
+    DataStream ds;
+    write_per_element(ds, input(state.range(0)));
+    vector<double> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * output.size() * sizeof(double));
+}
+BENCHMARK(bm_read_per_element)->arg(16)->arg(1024)->arg(1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Account : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_name, m_email, m_tags, m_scores, m_balance)
+
+    int64_t m_id;
+    string m_name;
+    string m_email;
+    vector<string> m_tags;
+    vector<int32_t> m_scores;
+    double m_balance;
+};
+
+// a 64K account snapshot, the kind of stream that goes to disk
+static const DataStream & snapshot()
+{
+    static DataStream ds;
+    if (ds.size() == 0)
+    {
+        vector<Account> value(64 << 10);
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            Account & a = value[i];
+            a.m_id = i;
+            a.m_name = "account holder " + std::to_string(i);
+            a.m_email = "holder" + std::to_string(i) + "@example.com";
+            a.m_tags = { "retail", "region-" + std::to_string(i % 8) };
+            a.m_scores = vector<int32_t>(8, i % 100);
+            a.m_balance = (i % 1000) * 1.5;
+        }
+        ds << value;
+    }
+    return ds;
+}
+
+static string ratio_label(int raw, int packed)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "ratio %.2f", (double)raw / packed);
+    return text;
+}
+
+// range(0) is the codec, 0 store, 1 lz; range(1) the block size in KB
+static void bm_compress(State & state)
+{
+    const DataStream & ds = snapshot();
+    Buffer out;
+    for (auto _ : state)
+    {
+        out.clear();
+        compress(ds.data(), ds.size(), out, (Codec)state.range(0), state.range(1) << 10);
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(ratio_label(ds.size(), out.size()));
+}
+BENCHMARK(bm_compress)->args({ 0, 64 })->args({ 1, 16 })->args({ 1, 64 })->args({ 1, 256 });
+
+// same arguments, bytes are counted on the decompressed side
+static void bm_decompress(State & state)
+{
+    const DataStream & ds = snapshot();
+    Buffer packed;
+    compress(ds.data(), ds.size(), packed, (Codec)state.range(0), state.range(1) << 10);
+    Buffer out;
+    for (auto _ : state)
+    {
+        decompress(packed.data(), packed.size(), out);
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(ratio_label(ds.size(), packed.size()));
+}
+BENCHMARK(bm_decompress)->args({ 0, 64 })->args({ 1, 16 })->args({ 1, 64 })->args({ 1, 256 });
+
+// lz with 64KB blocks, range(0) is the thread count
+static void bm_decompress_threads(State & state)
+{
+    const DataStream & ds = snapshot();
+    Buffer packed;
+    compress(ds.data(), ds.size(), packed);
+    Buffer out;
+    for (auto _ : state)
+    {
+        decompress(packed.data(), packed.size(), out, state.range(0));
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(std::to_string(std::thread::hardware_concurrency()) + " cores");
+}
+BENCHMARK(bm_decompress_threads)->arg(1)->arg(4);
+
+// a snapshot file written and loaded back, range(0) 0 plain, 1 lz
+static void bm_save_load(State & state)
+{
+    const DataStream & ds = snapshot();
+    string filename = "/tmp/compress_bench.bin";
+    DataStream copy;
+    copy.write(ds.data(), ds.size());
+    DataStream in;
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            copy.save(filename, LzCodec);
+        }
+        else
+        {
+            copy.save(filename);
+        }
+        in.load(filename);
+    }
+    std::remove(filename.c_str());
+    state.set_bytes_processed(state.iterations() * ds.size());
+}
+BENCHMARK(bm_save_load)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,144 @@
+#include <array>
+#include <deque>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+static unordered_map<string, int64_t> sessions(int n)
+{
+    unordered_map<string, int64_t> value;
+    for (int i = 0; i < n; i++)
+    {
+        value["session-" + std::to_string(i * 7919)] = i;
+    }
+    return value;
+}
+
+// range(0) 0 goes through a std::map copy the way callers had to, 1 native
+static void bm_encode_unordered_map(State & state)
+{
+    unordered_map<string, int64_t> input = sessions(state.range(1));
+    DataStream ds;
+    for (auto _ : state)
+    {
+        ds.clear();
+        if (state.range(0))
+        {
+            ds << input;
+        }
+        else
+        {
+            ds << map<string, int64_t>(input.begin(), input.end());
+        }
+    }
+    state.set_items_processed(state.iterations() * input.size());
+}
+BENCHMARK(bm_encode_unordered_map)->args({ 0, 64 << 10 })->args({ 1, 64 << 10 });
+
+// range(0) 0 decodes into a std::map and copies, 1 native with reserve
+static void bm_decode_unordered_map(State & state)
+{
+    DataStream ds;
+    ds << sessions(state.range(1));
+    unordered_map<string, int64_t> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        if (state.range(0))
+        {
+            ds >> output;
+        }
+        else
+        {
+            map<string, int64_t> value;
+            ds >> value;
+            output = unordered_map<string, int64_t>(value.begin(), value.end());
+        }
+    }
+    state.set_items_processed(state.iterations() * output.size());
+}
+BENCHMARK(bm_decode_unordered_map)->args({ 0, 64 << 10 })->args({ 1, 64 << 10 });
+
+// fixed size arrays of doubles: range(0) 0 as a vector copy, 1 native block
+static void bm_array(State & state)
+{
+    vector<array<double, 16>> input(16 << 10);
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        input[i].fill(i * 0.5);
+    }
+    DataStream ds;
+    array<double, 16> output;
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds.reset();
+        for (auto & item : input)
+        {
+            if (state.range(0))
+            {
+                ds << item;
+            }
+            else
+            {
+                ds << vector<double>(item.begin(), item.end());
+            }
+        }
+        for (size_t i = 0; i < input.size(); i++)
+        {
+            if (state.range(0))
+            {
+                ds >> output;
+            }
+            else
+            {
+                vector<double> value;
+                ds >> value;
+                std::copy(value.begin(), value.end(), output.begin());
+            }
+        }
+    }
+    do_not_optimize(output);
+    state.set_bytes_processed(state.iterations() * input.size() * sizeof(output));
+}
+BENCHMARK(bm_array)->arg(0)->arg(1);
+
+// a deque of ints: range(0) 0 via a vector copy, 1 native
+static void bm_deque(State & state)
+{
+    deque<int32_t> input;
+    for (int i = 0; i < (256 << 10); i++)
+    {
+        input.push_back(i);
+    }
+    DataStream ds;
+    deque<int32_t> output;
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds.reset();
+        if (state.range(0))
+        {
+            ds << input;
+            ds >> output;
+        }
+        else
+        {
+            ds << vector<int32_t>(input.begin(), input.end());
+            vector<int32_t> value;
+            ds >> value;
+            output.assign(value.begin(), value.end());
+        }
+    }
+    state.set_bytes_processed(state.iterations() * input.size() * sizeof(int32_t));
+}
+BENCHMARK(bm_deque)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,168 @@
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Order : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_user, m_price, m_quantity, m_symbol, m_fills, m_tags)
+
+    int64_t m_id;
+    int32_t m_user;
+    double m_price;
+    int32_t m_quantity;
+    string m_symbol;
+    vector<double> m_fills;
+    map<string, int32_t> m_tags;
+};
+
+class Tick : public Serializable
+{
+public:
+    SERIALIZE_SCHEMA(m_time, m_bid, m_ask, m_size)
+
+    int64_t m_time;
+    double m_bid;
+    double m_ask;
+    int32_t m_size;
+};
+
+static vector<Order> orders()
+{
+    vector<Order> value(2048);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_id = i;
+        value[i].m_user = i % 97;
+        value[i].m_price = 100.0 + i;
+        value[i].m_quantity = i % 13;
+        value[i].m_symbol = "SYM" + std::to_string(i % 50);
+        value[i].m_fills = { 1.0, 2.0, 3.0 };
+        value[i].m_tags = { { "desk", 1 }, { "venue", 2 } };
+    }
+    return value;
+}
+
+static vector<Tick> ticks()
+{
+    vector<Tick> value(16384);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_time = i;
+        value[i].m_bid = i * 0.5;
+        value[i].m_ask = i * 0.5 + 0.25;
+        value[i].m_size = i % 100;
+    }
+    return value;
+}
+
+template <typename T, vector<T> (*make)()>
+static void bm_decode(State & state)
+{
+    DataStream ds;
+    for (auto & item : make())
+    {
+        ds << item;
+    }
+    vector<T> output(make().size());
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (auto & item : output)
+        {
+            ds >> item;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * output.size());
+}
+BENCHMARK_TEMPLATE(bm_decode, Order, orders);
+BENCHMARK_TEMPLATE(bm_decode, Tick, ticks);
+
+static void bm_decode_scalars(State & state)
+{
+    DataStream ds;
+    for (int i = 0; i < 16384; i++)
+    {
+        ds << (int32_t)i << (double)i;
+    }
+    int32_t n = 0;
+    double d = 0;
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (int i = 0; i < 16384; i++)
+        {
+            ds >> n >> d;
+        }
+    }
+    do_not_optimize(n);
+    do_not_optimize(d);
+    state.set_bytes_processed(state.iterations() * ds.size());
+}
+BENCHMARK(bm_decode_scalars);
+
+static void bm_decode_strings_map(State & state)
+{
+    vector<string> names(4096);
+    map<string, string> attrs;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        names[i] = "a reasonably long name that defeats sso " + std::to_string(i);
+        attrs[names[i]] = names[i];
+    }
+    DataStream ds;
+    ds << names << attrs;
+    vector<string> names_out;
+    map<string, string> attrs_out;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> names_out >> attrs_out;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+}
+BENCHMARK(bm_decode_strings_map);
+
+// a message arriving in 1500 byte segments, decoded as data comes in:
+// range(0) 0 re-parses from the start after every segment, 1 resumes
+static void bm_receive(State & state)
+{
+    vector<Order> input = orders();
+    input.resize(256);
+    DataStream encoded;
+    encoded << input;
+    const int segment = 1500;
+    for (auto _ : state)
+    {
+        DataStream ds;
+        ds.set_incremental(state.range(0));
+        vector<Order> output;
+        for (int off = 0; off < encoded.size(); off += segment)
+        {
+            if (!state.range(0))
+            {
+                ds.reset();
+            }
+            ds.feed(encoded.data() + off, std::min<int64_t>(segment, encoded.size() - off));
+            if (ds.read(output))
+            {
+                break;
+            }
+        }
+        if (output.size() != input.size())
+        {
+            state.set_label("decode failed");
+        }
+    }
+    state.set_bytes_processed(state.iterations() * encoded.size());
+}
+BENCHMARK(bm_receive)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
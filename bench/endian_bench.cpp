@@ -0,0 +1,120 @@
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// x86 is little endian like the default wire, so these force a big endian
+// wire to put every value through the swap path
+
+static vector<double> input(long n)
+{
+    vector<double> value(n);
+    for (long i = 0; i < n; i++)
+    {
+        value[i] = i * 0.5;
+    }
+    return value;
+}
+
+static const char * kernel_name(SwapKernel kernel)
+{
+    switch (kernel)
+    {
+    case Avx2Swap:
+        return "avx2";
+    case Ssse3Swap:
+        return "ssse3";
+    default:
+        return "scalar";
+    }
+}
+
+// range(0) picks the kernel: 0 scalar, 1 ssse3, 2 avx2; range(1) the width
+static void bm_swap_bytes(State & state)
+{
+    SwapKernel saved = swap_kernel();
+    if (!set_swap_kernel((SwapKernel)state.range(0)))
+    {
+        state.set_label("unsupported");
+        for (auto _ : state)
+        {
+        }
+        return;
+    }
+    vector<char> src(256 << 10, 1);
+    vector<char> dst(src.size());
+    for (auto _ : state)
+    {
+        swap_bytes(dst.data(), src.data(), src.size(), state.range(1));
+        clobber_memory();
+    }
+    set_swap_kernel(saved);
+    state.set_bytes_processed(state.iterations() * src.size());
+    state.set_label(kernel_name((SwapKernel)state.range(0)));
+}
+BENCHMARK(bm_swap_bytes)->args({ 0, 2 })->args({ 1, 2 })->args({ 2, 2 })
+                        ->args({ 0, 4 })->args({ 1, 4 })->args({ 2, 4 })
+                        ->args({ 0, 8 })->args({ 1, 8 })->args({ 2, 8 });
+
+// a packed vector<double>: range(0) 0 little endian wire, 1 big endian
+static void bm_write_array(State & state)
+{
+    vector<double> value = input(64 << 10);
+    DataStream ds;
+    ds.set_byteorder(state.range(0) ? DataStream::BigEndian : DataStream::LittleEndian);
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << value;
+    }
+    state.set_bytes_processed(state.iterations() * value.size() * sizeof(double));
+    state.set_label(kernel_name(swap_kernel()));
+}
+BENCHMARK(bm_write_array)->arg(0)->arg(1);
+
+static void bm_read_array(State & state)
+{
+    DataStream ds;
+    ds.set_byteorder(state.range(0) ? DataStream::BigEndian : DataStream::LittleEndian);
+    ds << input(64 << 10);
+    vector<double> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * output.size() * sizeof(double));
+    state.set_label(kernel_name(swap_kernel()));
+}
+BENCHMARK(bm_read_array)->arg(0)->arg(1);
+
+// tagged scalars one at a time: range(0) 0 little endian wire, 1 big endian
+static void bm_scalars(State & state)
+{
+    DataStream ds;
+    ds.set_byteorder(state.range(0) ? DataStream::BigEndian : DataStream::LittleEndian);
+    int32_t n = 0;
+    double d = 0;
+    for (auto _ : state)
+    {
+        ds.clear();
+        for (int i = 0; i < 4096; i++)
+        {
+            ds << (int32_t)i << i * 0.5;
+        }
+        ds.reset();
+        for (int i = 0; i < 4096; i++)
+        {
+            ds >> n >> d;
+        }
+    }
+    do_not_optimize(n);
+    do_not_optimize(d);
+    state.set_items_processed(state.iterations() * 8192);
+}
+BENCHMARK(bm_scalars)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,211 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+
+// usage: file_bench [size in MB ...] [-f path], defaults to a 64 MB snapshot
+// every measurement runs in its own process so that peak RSS is per mode
+
+static const int kChunk = 8 << 20;
+
+// a state dump: one root object holding many small ones
+class Entry : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_value)
+
+    int64_t m_id;
+    double m_value;
+};
+
+class Dump : public Serializable
+{
+public:
+    SERIALIZE(m_name, m_entries)
+
+    string m_name;
+    vector<Entry> m_entries;
+};
+
+static double now_ms()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void build(DataStream & ds, long mb)
+{
+    vector<double> chunk(kChunk / sizeof(double));
+    for (size_t i = 0; i < chunk.size(); i++)
+    {
+        chunk[i] = i * 0.25;
+    }
+    for (long i = 0; i < mb * (1 << 20) / kChunk; i++)
+    {
+        ds << chunk;
+    }
+}
+
+static double scan(DataStream & ds)
+{
+    double sum = 0;
+    ArrayView<double> view;
+    while (ds.read(view))
+    {
+        sum += view[0] + view[view.size() - 1];
+        for (int i = 0; i < view.size(); i += 512)
+        {
+            sum += view[i];
+        }
+    }
+    return sum;
+}
+
+static void save_stream(DataStream & ds, const string & path)
+{
+    ofstream fout(path);
+    fout.write(ds.data(), ds.size());
+    fout.flush();
+    fout.close();
+}
+
+static void load_stream(DataStream & ds, const string & path)
+{
+    ifstream fin(path);
+    stringstream ss;
+    ss << fin.rdbuf();
+    const string & str = ss.str();
+    ds.clear();
+    ds.write(str.data(), str.size());
+}
+
+static void run(const string & mode, const string & path, long mb)
+{
+    double start = now_ms();
+    double ready = 0;
+    if (mode == "sink")
+    {
+        // encodes straight to the file, ready includes building the payload
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        FdSink sink(fd);
+        DataStream ds;
+        ds.set_sink(&sink);
+        build(ds, mb);
+        ds.flush();
+        ::close(fd);
+        ready = now_ms();
+    }
+    else if (mode == "callback")
+    {
+        // the dump goes through a sink that cannot be patched, like a pipe
+        // or socket, so nothing may be held back until the root closes; the
+        // entries are about 20 bytes each once encoded
+        Dump dump;
+        dump.m_name = "state";
+        dump.m_entries.resize(mb * 50000);
+        for (size_t i = 0; i < dump.m_entries.size(); i++)
+        {
+            dump.m_entries[i].m_id = i;
+            dump.m_entries[i].m_value = i * 0.5;
+        }
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        int largest = 0;
+        CallbackSink sink([&](const char * data, int len)
+        {
+            largest = std::max(largest, len);
+            return ::write(fd, data, len) == len;
+        });
+        start = now_ms();
+        {
+            DataStream ds;
+            ds.set_sink(&sink);
+            ds << dump;
+        }
+        ::close(fd);
+        ready = now_ms();
+        std::printf("%-12s %6ld MB  largest write %.1f KB\n", mode.c_str(), mb, largest / 1024.0);
+    }
+    else if (mode == "save_stream" || mode == "save")
+    {
+        DataStream ds;
+        build(ds, mb);
+        start = now_ms();
+        mode == "save" ? ds.save(path) : save_stream(ds, path);
+        ready = now_ms();
+    }
+    else
+    {
+        DataStream ds;
+        if (mode == "load_stream")
+        {
+            load_stream(ds, path);
+        }
+        else if (mode == "load")
+        {
+            ds.load(path);
+        }
+        else
+        {
+            ds.map(path);
+        }
+        ready = now_ms();
+        volatile double sum = scan(ds);
+        (void)sum;
+    }
+    double done = now_ms();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::printf("%-12s %6ld MB  ready %9.1f ms  scanned %9.1f ms  peak rss %8.1f MB\n",
+        mode.c_str(), mb, ready - start, done - start, usage.ru_maxrss / 1024.0);
+    std::fflush(stdout);
+}
+
+int main(int argc, char * argv[])
+{
+    vector<long> sizes;
+    string path = "file_bench.dat";
+    for (int i = 1; i < argc; i++)
+    {
+        if (string(argv[i]) == "-f" && i + 1 < argc)
+        {
+            path = argv[++i];
+        }
+        else
+        {
+            sizes.push_back(atol(argv[i]));
+        }
+    }
+    if (sizes.empty())
+    {
+        sizes.push_back(64);
+    }
+    const char * modes[] = { "sink", "callback", "save_stream", "save", "load_stream", "load", "map" };
+    for (long mb : sizes)
+    {
+        for (const char * mode : modes)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                run(mode, path, mb);
+                _exit(0);
+            }
+            int status;
+            waitpid(pid, &status, 0);
+        }
+    }
+    unlink(path.c_str());
+    return 0;
+}
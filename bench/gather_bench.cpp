@@ -0,0 +1,156 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// a reply carrying a large attachment, as sent to a client socket
+class Reply : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_type, m_name, m_attachment)
+
+    int64_t m_id;
+    string m_type;
+    string m_name;
+    string m_attachment;
+};
+
+static int devnull()
+{
+    static int fd = ::open("/dev/null", O_WRONLY);
+    return fd;
+}
+
+// range(0) 0 copies everything and writes the buffer, 1 gathers payloads of
+// 4KB or more and writes with writev; range(1) the attachment size in KB
+static void bm_send(State & state)
+{
+    Reply reply;
+    reply.m_id = 42;
+    reply.m_type = "application/octet-stream";
+    reply.m_name = "snapshot-0042.bin";
+    reply.m_attachment.assign(state.range(1) << 10, 'x');
+    DataStream ds;
+    ds.set_gather(state.range(0) ? 4096 : 0);
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << reply;
+        if (state.range(0))
+        {
+            ds.writev(devnull());
+        }
+        else
+        {
+            ssize_t n = ::write(devnull(), ds.data(), ds.size());
+            do_not_optimize(n);
+        }
+    }
+    state.set_bytes_processed(state.iterations() * reply.m_attachment.size());
+}
+BENCHMARK(bm_send)->args({ 0, 1 })->args({ 1, 1 })->args({ 0, 64 })->args({ 1, 64 })->args({ 0, 4096 })->args({ 1, 4096 });
+
+// a batch of replies with small and large attachments mixed, range(0) as above
+static void bm_send_batch(State & state)
+{
+    vector<Reply> batch(64);
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        batch[i].m_id = i;
+        batch[i].m_type = "text/plain";
+        batch[i].m_name = "part-" + std::to_string(i);
+        batch[i].m_attachment.assign(i % 4 == 0 ? 256 << 10 : 200, 'y');
+    }
+    int64_t bytes = 0;
+    for (auto & r : batch)
+    {
+        bytes += r.m_attachment.size();
+    }
+    DataStream ds;
+    ds.set_gather(state.range(0) ? 4096 : 0);
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << batch;
+        if (state.range(0))
+        {
+            ds.writev(devnull());
+        }
+        else
+        {
+            ssize_t n = ::write(devnull(), ds.data(), ds.size());
+            do_not_optimize(n);
+        }
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+    state.set_label(std::to_string(ds.size() / 1024) + " KB copied");
+}
+BENCHMARK(bm_send_batch)->arg(0)->arg(1);
+
+// reads the gathered bytes back as records, the count that decode intact
+static int64_t records_back(const DataStream & ds, const vector<Reply> & batch)
+{
+    std::vector<struct iovec> vec;
+    ds.iovecs(vec);
+    string bytes;
+    for (auto & v : vec)
+    {
+        bytes.append((const char *)v.iov_base, v.iov_len);
+    }
+    DataStream in(bytes);
+    StringView payload;
+    int64_t good = 0;
+    for (size_t i = 0; i < batch.size() && in.read_record(payload); i++)
+    {
+        DataStream record(string(payload.data(), payload.size()));
+        Reply reply;
+        if (record.read(reply) && reply.m_attachment == batch[i].m_attachment)
+        {
+            good++;
+        }
+    }
+    return good;
+}
+
+// the same batch as length-delimited records, back to back, each ending in
+// its attachment; range(0) 0 copies, 1 gathers, range(1) 1 adds checksums
+static void bm_send_records(State & state)
+{
+    vector<Reply> batch(64);
+    int64_t bytes = 0;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        batch[i].m_id = i;
+        batch[i].m_type = "text/plain";
+        batch[i].m_name = "part-" + std::to_string(i);
+        batch[i].m_attachment.assign(i % 4 == 0 ? 256 << 10 : 200, 'a' + i % 26);
+        bytes += batch[i].m_attachment.size();
+    }
+    DataStream ds;
+    ds.set_gather(state.range(0) ? 4096 : 0);
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds.write_records(batch.begin(), batch.end(), state.range(1));
+        if (state.range(0))
+        {
+            ds.writev(devnull());
+        }
+        else
+        {
+            ssize_t n = ::write(devnull(), ds.data(), ds.size());
+            do_not_optimize(n);
+        }
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+    state.set_label(std::to_string(records_back(ds, batch)) + "/" + std::to_string(batch.size()) + " records read back");
+}
+BENCHMARK(bm_send_records)->args({ 0, 0 })->args({ 1, 0 })->args({ 0, 1 })->args({ 1, 1 });
+
+BENCHMARK_MAIN();
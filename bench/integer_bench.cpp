@@ -0,0 +1,131 @@
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// a sample row as it is declared, and the same row widened to int64 the
+// way it had to be written before the unsigned and narrow types had tags
+class Sample : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_port, m_status, m_flags, m_bytes)
+
+    uint64_t m_id;
+    uint16_t m_port;
+    uint8_t m_status;
+    uint32_t m_flags;
+    uint32_t m_bytes;
+};
+
+class WideSample : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_port, m_status, m_flags, m_bytes)
+
+    int64_t m_id;
+    int64_t m_port;
+    int64_t m_status;
+    int64_t m_flags;
+    int64_t m_bytes;
+};
+
+static const int kRows = 64 << 10;
+
+template <typename T>
+static vector<T> rows()
+{
+    vector<T> value(kRows);
+    for (int i = 0; i < kRows; i++)
+    {
+        value[i].m_id = 1000000000000ll + i;
+        value[i].m_port = 1024 + i % 50000;
+        value[i].m_status = i % 5;
+        value[i].m_flags = i % 7 == 0 ? 3000000000u : i % 16;
+        value[i].m_bytes = i * 37 % 100000;
+    }
+    return value;
+}
+
+static string size_label(int64_t size)
+{
+    return std::to_string(size / 1024) + " KB";
+}
+
+template <typename T>
+static void encode(State & state)
+{
+    vector<T> input = rows<T>();
+    DataStream ds;
+    ds.set_compact(state.range(0));
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << input;
+    }
+    state.set_items_processed(state.iterations() * input.size());
+    state.set_label(size_label(ds.size()));
+}
+
+template <typename T>
+static void decode(State & state)
+{
+    DataStream ds;
+    ds.set_compact(state.range(0));
+    ds << rows<T>();
+    vector<T> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_items_processed(state.iterations() * output.size());
+    state.set_label(size_label(ds.size()));
+}
+
+// range(0) 0 tagged, 1 compact
+static void bm_encode_native(State & state) { encode<Sample>(state); }
+static void bm_encode_widened(State & state) { encode<WideSample>(state); }
+static void bm_decode_native(State & state) { decode<Sample>(state); }
+static void bm_decode_widened(State & state) { decode<WideSample>(state); }
+BENCHMARK(bm_encode_native)->arg(0)->arg(1);
+BENCHMARK(bm_encode_widened)->arg(0)->arg(1);
+BENCHMARK(bm_decode_native)->arg(0)->arg(1);
+BENCHMARK(bm_decode_widened)->arg(0)->arg(1);
+
+// a column of ports as one packed block: range(0) 0 widened to int64, 1 uint16
+static void bm_packed_ports(State & state)
+{
+    vector<uint16_t> ports(1 << 20);
+    for (size_t i = 0; i < ports.size(); i++)
+    {
+        ports[i] = 1024 + i % 50000;
+    }
+    vector<int64_t> wide(ports.begin(), ports.end());
+    DataStream ds;
+    vector<uint16_t> narrow_out;
+    vector<int64_t> wide_out;
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds.reset();
+        if (state.range(0))
+        {
+            ds << ports;
+            ds >> narrow_out;
+        }
+        else
+        {
+            ds << wide;
+            ds >> wide_out;
+        }
+    }
+    state.set_items_processed(state.iterations() * ports.size());
+    state.set_label(size_label(ds.size()));
+}
+BENCHMARK(bm_packed_ports)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,138 @@
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Order : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_customer, m_status, m_currency, m_tags)
+
+    int64_t m_id;
+    string m_customer;
+    string m_status;
+    string m_currency;
+    vector<string> m_tags;
+};
+
+// 64K orders whose status, currency and tags come from a handful of values
+static const vector<Order> & orders()
+{
+    static vector<Order> value;
+    if (value.empty())
+    {
+        static const char * status[] = { "pending", "shipped", "delivered", "cancelled" };
+        static const char * currency[] = { "USD", "EUR", "GBP" };
+        value.resize(64 << 10);
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            Order & o = value[i];
+            o.m_id = i;
+            o.m_customer = "customer-" + std::to_string(i % 500);
+            o.m_status = status[i % 4];
+            o.m_currency = currency[i % 3];
+            o.m_tags = { "priority-" + std::to_string(i % 3), "warehouse-east" };
+        }
+    }
+    return value;
+}
+
+static string size_label(int size)
+{
+    return std::to_string(size / 1024) + " KB";
+}
+
+// range(0) 0 strings in full, 1 interned
+static void bm_encode_orders(State & state)
+{
+    const vector<Order> & input = orders();
+    DataStream ds;
+    ds.set_interned(state.range(0));
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << input;
+    }
+    state.set_items_processed(state.iterations() * input.size());
+    state.set_label(size_label(ds.size()));
+}
+BENCHMARK(bm_encode_orders)->arg(0)->arg(1);
+
+static void bm_decode_orders(State & state)
+{
+    DataStream ds;
+    ds.set_interned(state.range(0));
+    ds << orders();
+    vector<Order> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_items_processed(state.iterations() * output.size());
+    state.set_label(size_label(ds.size()));
+}
+BENCHMARK(bm_decode_orders)->arg(0)->arg(1);
+
+// a map keyed by a few hundred long names, as written in every snapshot
+static map<string, int32_t> directory(int i)
+{
+    map<string, int32_t> value;
+    for (int k = 0; k < 300; k++)
+    {
+        value["service.endpoint." + std::to_string(k) + ".latency_ms"] = i + k;
+    }
+    return value;
+}
+
+static void bm_decode_maps(State & state)
+{
+    DataStream ds;
+    ds.set_interned(state.range(0));
+    for (int i = 0; i < 256; i++)
+    {
+        ds << directory(i);
+    }
+    map<string, int32_t> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (int i = 0; i < 256; i++)
+        {
+            ds >> output;
+        }
+    }
+    state.set_items_processed(state.iterations() * 256 * 300);
+    state.set_label(size_label(ds.size()));
+}
+BENCHMARK(bm_decode_maps)->arg(0)->arg(1);
+
+// the status column read as views, which share the bytes of the first copy
+// when interned instead of pointing at a copy of their own
+static void bm_decode_views(State & state)
+{
+    vector<string> input;
+    for (auto & o : orders())
+    {
+        input.push_back(o.m_status);
+    }
+    DataStream ds;
+    ds.set_interned(state.range(0));
+    ds << input;
+    vector<StringView> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_items_processed(state.iterations() * output.size());
+    state.set_label(size_label(ds.size()));
+}
+BENCHMARK(bm_decode_views)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
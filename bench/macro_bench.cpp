@@ -0,0 +1,198 @@
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// round trips of realistic objects: encode into a fresh stream and decode
+// into a fresh object, so allocs/op covers the whole lifecycle
+
+class Address : public Serializable
+{
+public:
+    SERIALIZE(m_street, m_city, m_zip)
+
+    string m_street;
+    string m_city;
+    int32_t m_zip;
+};
+
+class Customer : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_name, m_email, m_vip, m_balance, m_address, m_phones, m_groups)
+
+    int64_t m_id;
+    string m_name;
+    string m_email;
+    bool m_vip;
+    double m_balance;
+    Address m_address;
+    vector<string> m_phones;
+    set<int32_t> m_groups;
+};
+
+class Line : public Serializable
+{
+public:
+    SERIALIZE(m_sku, m_quantity, m_price)
+
+    string m_sku;
+    int32_t m_quantity;
+    double m_price;
+};
+
+class Invoice : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_customer, m_lines, m_notes, m_attrs, m_history)
+
+    int64_t m_id;
+    Customer m_customer;
+    vector<Line> m_lines;
+    list<string> m_notes;
+    map<string, string> m_attrs;
+    vector<int64_t> m_history;
+};
+
+// same wire format as a plain struct, decoded into arena backed members
+template <typename String, template <typename> class Vector>
+class Message : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_user, m_body, m_tags, m_scores)
+
+    int64_t m_id;
+    String m_user;
+    String m_body;
+    Vector<String> m_tags;
+    Vector<int32_t> m_scores;
+};
+
+template <typename T>
+using HeapVector = std::vector<T>;
+
+typedef Message<string, HeapVector> HeapMessage;
+typedef Message<ArenaString, ArenaVector> ArenaMessage;
+
+static Customer customer(long i)
+{
+    Customer c;
+    c.m_id = 1000000 + i;
+    c.m_name = "customer number " + std::to_string(i);
+    c.m_email = "customer" + std::to_string(i) + "@example.com";
+    c.m_vip = i % 3 == 0;
+    c.m_balance = i * 12.5;
+    c.m_address.m_street = std::to_string(i) + " long and winding road";
+    c.m_address.m_city = "springfield";
+    c.m_address.m_zip = 10000 + i % 90000;
+    c.m_phones = { "+1-555-0100", "+1-555-0199" };
+    c.m_groups = { 1, 7, (int32_t)(i % 64) };
+    return c;
+}
+
+static Invoice invoice(long i, long lines)
+{
+    Invoice inv;
+    inv.m_id = i;
+    inv.m_customer = customer(i);
+    inv.m_lines.resize(lines);
+    for (long k = 0; k < lines; k++)
+    {
+        inv.m_lines[k].m_sku = "SKU-" + std::to_string(k * 31 + i);
+        inv.m_lines[k].m_quantity = k % 5 + 1;
+        inv.m_lines[k].m_price = 9.99 + k;
+    }
+    inv.m_notes = { "deliver before noon", "leave at the front desk" };
+    inv.m_attrs = { { "channel", "web" }, { "currency", "USD" }, { "region", "us-east" } };
+    for (long k = 0; k < lines * 4; k++)
+    {
+        inv.m_history.push_back(1700000000000LL + k * 1000);
+    }
+    return inv;
+}
+
+template <typename T>
+static void round_trip(State & state, const T & input)
+{
+    long bytes = 0;
+    for (auto _ : state)
+    {
+        DataStream ds;
+        ds << input;
+        T output;
+        ds >> output;
+        bytes = ds.size();
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+    state.set_label(std::to_string(bytes) + " bytes");
+}
+
+static void bm_round_trip_customer(State & state)
+{
+    round_trip(state, customer(42));
+}
+BENCHMARK(bm_round_trip_customer);
+
+static void bm_round_trip_invoice(State & state)
+{
+    round_trip(state, invoice(42, state.range(0)));
+}
+BENCHMARK(bm_round_trip_invoice)->arg(4)->arg(64)->arg(1024);
+
+static void bm_round_trip_batch(State & state)
+{
+    vector<Invoice> input;
+    for (long i = 0; i < state.range(0); i++)
+    {
+        input.push_back(invoice(i, 8));
+    }
+    round_trip(state, input);
+}
+BENCHMARK(bm_round_trip_batch)->arg(16)->arg(1024);
+
+static HeapMessage message()
+{
+    HeapMessage msg;
+    msg.m_id = 42;
+    msg.m_user = "someone with a long user name";
+    msg.m_body = string(200, 'x');
+    msg.m_tags = { "a tag that does not fit in sso", "another tag that does not fit" };
+    msg.m_scores = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    return msg;
+}
+
+static void bm_round_trip_message_heap(State & state)
+{
+    round_trip(state, message());
+}
+BENCHMARK(bm_round_trip_message_heap);
+
+// pooled stream buffer plus a request-scoped arena: no malloc once warmed up
+static void bm_round_trip_message_pooled(State & state)
+{
+    HeapMessage input = message();
+    Arena arena;
+    long bytes = 0;
+    for (auto _ : state)
+    {
+        Arena::Scope scope(arena);
+        DataStream ds(&BufferPool::local());
+        ds << input;
+        ArenaMessage output;
+        ds >> output;
+        bytes = ds.size();
+        arena.reset();
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+    state.set_label(std::to_string(bytes) + " bytes");
+}
+BENCHMARK(bm_round_trip_message_pooled);
+
+BENCHMARK_MAIN();
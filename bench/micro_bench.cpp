@@ -0,0 +1,237 @@
+#include <list>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// one write or read per iteration, streams are recycled every kBatch values
+static const int kBatch = 4096;
+
+class Pair : public Serializable
+{
+public:
+    SERIALIZE(m_key, m_value)
+
+    int32_t m_key;
+    double m_value;
+};
+
+template <typename T>
+static T make(long i);
+
+template <> bool make<bool>(long i) { return i % 2; }
+template <> char make<char>(long i) { return 'a' + i % 26; }
+template <> int32_t make<int32_t>(long i) { return i * 7; }
+template <> int64_t make<int64_t>(long i) { return i * 1000003; }
+template <> float make<float>(long i) { return i * 0.5f; }
+template <> double make<double>(long i) { return i * 0.25; }
+template <> string make<string>(long i) { return "value-" + std::to_string(i); }
+template <> Pair make<Pair>(long i)
+{
+    Pair p;
+    p.m_key = i;
+    p.m_value = i * 0.5;
+    return p;
+}
+
+template <typename T>
+static void bm_write(State & state)
+{
+    T value = make<T>(42);
+    DataStream ds;
+    int n = 0;
+    for (auto _ : state)
+    {
+        ds << value;
+        if (++n == kBatch)
+        {
+            ds.clear();
+            n = 0;
+        }
+    }
+    state.set_items_processed(state.iterations());
+}
+BENCHMARK_TEMPLATE(bm_write, bool);
+BENCHMARK_TEMPLATE(bm_write, char);
+BENCHMARK_TEMPLATE(bm_write, int32_t);
+BENCHMARK_TEMPLATE(bm_write, int64_t);
+BENCHMARK_TEMPLATE(bm_write, float);
+BENCHMARK_TEMPLATE(bm_write, double);
+BENCHMARK_TEMPLATE(bm_write, string);
+BENCHMARK_TEMPLATE(bm_write, Pair);
+
+template <typename T>
+static void bm_read(State & state)
+{
+    DataStream ds;
+    for (int i = 0; i < kBatch; i++)
+    {
+        ds << make<T>(i);
+    }
+    T value;
+    int n = 0;
+    for (auto _ : state)
+    {
+        ds >> value;
+        if (++n == kBatch)
+        {
+            ds.reset();
+            n = 0;
+        }
+    }
+    do_not_optimize(value);
+    state.set_items_processed(state.iterations());
+}
+BENCHMARK_TEMPLATE(bm_read, bool);
+BENCHMARK_TEMPLATE(bm_read, char);
+BENCHMARK_TEMPLATE(bm_read, int32_t);
+BENCHMARK_TEMPLATE(bm_read, int64_t);
+BENCHMARK_TEMPLATE(bm_read, float);
+BENCHMARK_TEMPLATE(bm_read, double);
+BENCHMARK_TEMPLATE(bm_read, string);
+BENCHMARK_TEMPLATE(bm_read, Pair);
+
+static void bm_write_cstring(State & state)
+{
+    const char * value = "hello kitty";
+    DataStream ds;
+    int n = 0;
+    for (auto _ : state)
+    {
+        ds << value;
+        if (++n == kBatch)
+        {
+            ds.clear();
+            n = 0;
+        }
+    }
+    state.set_items_processed(state.iterations());
+}
+BENCHMARK(bm_write_cstring);
+
+static void bm_write_string_len(State & state)
+{
+    string value(state.range(0), 'x');
+    DataStream ds;
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << value;
+    }
+    state.set_bytes_processed(state.iterations() * value.size());
+}
+BENCHMARK(bm_write_string_len)->arg(8)->arg(256)->arg(65536);
+
+static void bm_read_string_len(State & state)
+{
+    DataStream ds;
+    ds << string(state.range(0), 'x');
+    string value;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> value;
+    }
+    state.set_bytes_processed(state.iterations() * value.size());
+}
+BENCHMARK(bm_read_string_len)->arg(8)->arg(256)->arg(65536);
+
+template <typename C>
+static C make_container(long n);
+
+template <> vector<int32_t> make_container<vector<int32_t>>(long n)
+{
+    vector<int32_t> c;
+    for (long i = 0; i < n; i++)
+    {
+        c.push_back(make<int32_t>(i));
+    }
+    return c;
+}
+
+template <> vector<string> make_container<vector<string>>(long n)
+{
+    vector<string> c;
+    for (long i = 0; i < n; i++)
+    {
+        c.push_back(make<string>(i));
+    }
+    return c;
+}
+
+template <> list<int32_t> make_container<list<int32_t>>(long n)
+{
+    list<int32_t> c;
+    for (long i = 0; i < n; i++)
+    {
+        c.push_back(make<int32_t>(i));
+    }
+    return c;
+}
+
+template <> map<string, int32_t> make_container<map<string, int32_t>>(long n)
+{
+    map<string, int32_t> c;
+    for (long i = 0; i < n; i++)
+    {
+        c[make<string>(i)] = i;
+    }
+    return c;
+}
+
+template <> set<int32_t> make_container<set<int32_t>>(long n)
+{
+    set<int32_t> c;
+    for (long i = 0; i < n; i++)
+    {
+        c.insert(make<int32_t>(i));
+    }
+    return c;
+}
+
+template <typename C>
+static void bm_write_container(State & state)
+{
+    C value = make_container<C>(state.range(0));
+    DataStream ds;
+    ds << value;
+    long bytes = ds.size();
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << value;
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+}
+BENCHMARK_TEMPLATE(bm_write_container, vector<int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_write_container, vector<string>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_write_container, list<int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_write_container, map<string, int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_write_container, set<int32_t>)->arg(8)->arg(512)->arg(32768);
+
+template <typename C>
+static void bm_read_container(State & state)
+{
+    DataStream ds;
+    ds << make_container<C>(state.range(0));
+    C value;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> value;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+}
+BENCHMARK_TEMPLATE(bm_read_container, vector<int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_read_container, vector<string>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_read_container, list<int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_read_container, map<string, int32_t>)->arg(8)->arg(512)->arg(32768);
+BENCHMARK_TEMPLATE(bm_read_container, set<int32_t>)->arg(8)->arg(512)->arg(32768);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,148 @@
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Account : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_name, m_email, m_tags, m_scores, m_balance)
+
+    int64_t m_id;
+    string m_name;
+    string m_email;
+    vector<string> m_tags;
+    vector<int32_t> m_scores;
+    double m_balance;
+};
+
+static const vector<Account> & accounts()
+{
+    static vector<Account> value;
+    if (value.empty())
+    {
+        value.resize(256 << 10);
+        for (size_t i = 0; i < value.size(); i++)
+        {
+            Account & a = value[i];
+            a.m_id = i;
+            a.m_name = "account holder " + std::to_string(i);
+            a.m_email = "holder" + std::to_string(i) + "@example.com";
+            a.m_tags = { "retail", "region-" + std::to_string(i % 8) };
+            a.m_scores = vector<int32_t>(8, i);
+            a.m_balance = i * 1.5;
+        }
+    }
+    return value;
+}
+
+// a snapshot dump of 256K objects: range(0) is the thread count, 1 is serial
+static void bm_encode_snapshot(State & state)
+{
+    const vector<Account> & input = accounts();
+    DataStream ds;
+    ds.set_threads(state.range(0));
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << input;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * input.size());
+    state.set_label(std::to_string(std::thread::hardware_concurrency()) + " cores");
+}
+BENCHMARK(bm_encode_snapshot)->arg(1)->arg(2)->arg(4)->arg(8)->arg(16)->arg(32);
+
+static DataStream & snapshot()
+{
+    static DataStream ds;
+    if (ds.size() == 0)
+    {
+        ds.set_indexed(true);
+        ds << accounts();
+    }
+    return ds;
+}
+
+// decoding an indexed snapshot: range(0) is the thread count, 1 is serial
+static void bm_decode_snapshot(State & state)
+{
+    DataStream & ds = snapshot();
+    ds.set_threads(state.range(0));
+    vector<Account> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * output.size());
+    state.set_label(std::to_string(std::thread::hardware_concurrency()) + " cores");
+}
+BENCHMARK(bm_decode_snapshot)->arg(1)->arg(2)->arg(4)->arg(8)->arg(16)->arg(32);
+
+static DataStream & directory()
+{
+    static DataStream ds;
+    if (ds.size() == 0)
+    {
+        map<string, Account> value;
+        for (auto & a : accounts())
+        {
+            value[a.m_email] = a;
+        }
+        ds.set_indexed(true);
+        ds << value;
+    }
+    return ds;
+}
+
+// a map keyed by email, entries decoded in parallel and inserted in order
+static void bm_decode_map(State & state)
+{
+    DataStream & ds = directory();
+    ds.set_threads(state.range(0));
+    map<string, Account> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * output.size());
+    state.set_label(std::to_string(std::thread::hardware_concurrency()) + " cores");
+}
+BENCHMARK(bm_decode_map)->arg(1)->arg(4)->arg(16);
+
+// many mid-sized containers, each just over the threshold for a parallel
+// decode, so what it costs to hand the chunks to other threads shows
+static void bm_decode_batches(State & state)
+{
+    vector<vector<Account>> input(64);
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        input[i].assign(accounts().begin() + i * 512, accounts().begin() + (i + 1) * 512);
+    }
+    DataStream ds;
+    ds.set_indexed(true);
+    ds << input;
+    ds.set_threads(state.range(0), 256);
+    vector<vector<Account>> output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * input.size());
+    state.set_label(std::to_string(std::thread::hardware_concurrency()) + " cores");
+}
+BENCHMARK(bm_decode_batches)->arg(1)->arg(2)->arg(4);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,117 @@
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class LogLine : public Serializable
+{
+public:
+    SERIALIZE(m_time, m_level, m_host, m_message)
+
+    int64_t m_time;
+    int32_t m_level;
+    string m_host;
+    string m_message;
+};
+
+static vector<LogLine> lines()
+{
+    vector<LogLine> value(10000);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_time = 1700000000000LL + i;
+        value[i].m_level = i % 5;
+        value[i].m_host = "host-" + std::to_string(i % 16);
+        value[i].m_message = "request " + std::to_string(i) + " served in " + std::to_string(i % 300) + " ms";
+    }
+    return value;
+}
+
+static DataStream & batch(bool checksum)
+{
+    static DataStream ds[2];
+    if (ds[checksum].size() == 0)
+    {
+        vector<LogLine> input = lines();
+        ds[checksum].write_records(input.begin(), input.end(), checksum);
+    }
+    return ds[checksum];
+}
+
+// range(0): 0 = plain records, 1 = records with a checksum
+static void bm_write_records(State & state)
+{
+    vector<LogLine> input = lines();
+    DataStream ds;
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds.write_records(input.begin(), input.end(), state.range(0));
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * input.size());
+}
+BENCHMARK(bm_write_records)->arg(0)->arg(1);
+
+static void bm_skip_records(State & state)
+{
+    DataStream & ds = batch(state.range(0));
+    long n = 0;
+    for (auto _ : state)
+    {
+        ds.reset();
+        while (ds.skip_record())
+        {
+            n++;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(n);
+}
+BENCHMARK(bm_skip_records)->arg(0)->arg(1);
+
+static void bm_read_records(State & state)
+{
+    DataStream & ds = batch(state.range(0));
+    StringView payload;
+    long n = 0;
+    for (auto _ : state)
+    {
+        ds.reset();
+        while (ds.read_record(payload))
+        {
+            n++;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(n);
+}
+BENCHMARK(bm_read_records)->arg(0)->arg(1);
+
+static void bm_decode_records(State & state)
+{
+    DataStream & ds = batch(state.range(0));
+    StringView payload;
+    DataStream record;
+    LogLine line;
+    long n = 0;
+    for (auto _ : state)
+    {
+        ds.reset();
+        while (ds.read_record(payload))
+        {
+            record.attach(payload.data(), payload.size());
+            record >> line;
+            n++;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(n);
+}
+BENCHMARK(bm_decode_records)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,140 @@
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// the same nested shape twice: virtual Serializable objects and plain structs
+class VirtualPoint : public Serializable
+{
+public:
+    SERIALIZE(m_x, m_y)
+
+    int32_t m_x;
+    int32_t m_y;
+};
+
+class VirtualSegment : public Serializable
+{
+public:
+    SERIALIZE(m_from, m_to, m_color)
+
+    VirtualPoint m_from;
+    VirtualPoint m_to;
+    int32_t m_color;
+};
+
+struct PlainPoint
+{
+    int32_t m_x;
+    int32_t m_y;
+};
+
+struct PlainSegment
+{
+    PlainPoint m_from;
+    PlainPoint m_to;
+    int32_t m_color;
+};
+
+REFLECT(PlainPoint, m_x, m_y)
+REFLECT(PlainSegment, m_from, m_to, m_color)
+
+class VirtualTick : public Serializable
+{
+public:
+    SERIALIZE_SCHEMA(m_time, m_bid, m_ask)
+
+    int64_t m_time;
+    double m_bid;
+    double m_ask;
+};
+
+struct PlainTick
+{
+    int64_t m_time;
+    double m_bid;
+    double m_ask;
+};
+
+REFLECT_SCHEMA(PlainTick, m_time, m_bid, m_ask)
+
+template <typename T>
+static vector<T> segments()
+{
+    vector<T> value(4096);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_from.m_x = i;
+        value[i].m_from.m_y = i + 1;
+        value[i].m_to.m_x = i + 2;
+        value[i].m_to.m_y = i + 3;
+        value[i].m_color = i % 7;
+    }
+    return value;
+}
+
+template <typename T>
+static vector<T> ticks()
+{
+    vector<T> value(4096);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_time = i;
+        value[i].m_bid = i * 0.5;
+        value[i].m_ask = i * 0.5 + 0.25;
+    }
+    return value;
+}
+
+template <typename T, vector<T> (*make)()>
+static void bm_encode(State & state)
+{
+    vector<T> input = make();
+    DataStream ds;
+    for (auto _ : state)
+    {
+        ds.clear();
+        for (auto & item : input)
+        {
+            ds << item;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * input.size());
+}
+
+template <typename T, vector<T> (*make)()>
+static void bm_decode(State & state)
+{
+    DataStream ds;
+    for (auto & item : make())
+    {
+        ds << item;
+    }
+    vector<T> output(make().size());
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (auto & item : output)
+        {
+            ds >> item;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * output.size());
+}
+
+BENCHMARK_TEMPLATE(bm_encode, VirtualSegment, segments<VirtualSegment>);
+BENCHMARK_TEMPLATE(bm_encode, PlainSegment, segments<PlainSegment>);
+BENCHMARK_TEMPLATE(bm_encode, VirtualTick, ticks<VirtualTick>);
+BENCHMARK_TEMPLATE(bm_encode, PlainTick, ticks<PlainTick>);
+BENCHMARK_TEMPLATE(bm_decode, VirtualSegment, segments<VirtualSegment>);
+BENCHMARK_TEMPLATE(bm_decode, PlainSegment, segments<PlainSegment>);
+BENCHMARK_TEMPLATE(bm_decode, VirtualTick, ticks<VirtualTick>);
+BENCHMARK_TEMPLATE(bm_decode, PlainTick, ticks<PlainTick>);
+
+BENCHMARK_MAIN();
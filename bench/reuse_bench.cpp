@@ -0,0 +1,61 @@
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+// a request passed from the encoding thread to the one decoding it
+class Message : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_method, m_args, m_body)
+
+    int64_t m_id;
+    string m_method;
+    vector<int32_t> m_args;
+    string m_body;
+};
+
+// range(0) 0 encodes into a fresh stream, copies the bytes out as a string
+// and decodes from a stream copied from it, 1 reuses both streams and hands
+// the bytes over with swap; range(1) the body size in bytes
+static void bm_handoff(State & state)
+{
+    Message msg;
+    msg.m_id = 7;
+    msg.m_method = "store.put";
+    msg.m_args.assign(16, 3);
+    msg.m_body.assign(state.range(1), 'b');
+    Message back;
+    DataStream out;
+    DataStream in;
+    Buffer wire;
+    for (auto _ : state)
+    {
+        if (state.range(0))
+        {
+            out.clear();
+            out << msg;
+            out.swap(wire);
+            in.swap(wire);
+            in >> back;
+        }
+        else
+        {
+            DataStream ds;
+            ds << msg;
+            string bytes(ds.data(), ds.size());
+            DataStream copy(bytes);
+            copy >> back;
+        }
+    }
+    do_not_optimize(back.m_id);
+    state.set_items_processed(state.iterations());
+    state.set_bytes_processed(state.iterations() * msg.m_body.size());
+}
+BENCHMARK(bm_handoff)->args({ 0, 64 })->args({ 1, 64 })->args({ 0, 4096 })->args({ 1, 4096 })->args({ 0, 256 << 10 })->args({ 1, 256 << 10 });
+
+BENCHMARK_MAIN();
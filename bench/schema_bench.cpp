@@ -0,0 +1,135 @@
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Point : public Serializable
+{
+public:
+    SERIALIZE(m_x, m_y, m_z, m_id, m_flag)
+
+    double m_x;
+    double m_y;
+    double m_z;
+    int32_t m_id;
+    bool m_flag;
+};
+
+class PointSchema : public Serializable
+{
+public:
+    SERIALIZE_SCHEMA(m_x, m_y, m_z, m_id, m_flag)
+
+    double m_x;
+    double m_y;
+    double m_z;
+    int32_t m_id;
+    bool m_flag;
+};
+
+class User : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_age, m_name, m_email, m_scores)
+
+    int64_t m_id;
+    int32_t m_age;
+    string m_name;
+    string m_email;
+    vector<int32_t> m_scores;
+};
+
+class UserSchema : public Serializable
+{
+public:
+    SERIALIZE_SCHEMA(m_id, m_age, m_name, m_email, m_scores)
+
+    int64_t m_id;
+    int32_t m_age;
+    string m_name;
+    string m_email;
+    vector<int32_t> m_scores;
+};
+
+template <typename T>
+static vector<T> points()
+{
+    vector<T> result(4096);
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        result[i].m_x = i;
+        result[i].m_y = i * 2.0;
+        result[i].m_z = i * 3.0;
+        result[i].m_id = i;
+        result[i].m_flag = i % 2;
+    }
+    return result;
+}
+
+template <typename T>
+static vector<T> users()
+{
+    vector<T> result(4096);
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        result[i].m_id = i;
+        result[i].m_age = 20 + i % 50;
+        result[i].m_name = "user" + std::to_string(i);
+        result[i].m_email = result[i].m_name + "@example.com";
+        result[i].m_scores = { 1, 2, 3 };
+    }
+    return result;
+}
+
+template <typename T, vector<T> (*make)()>
+static void bm_write(State & state)
+{
+    vector<T> input = make();
+    DataStream ds;
+    for (auto _ : state)
+    {
+        ds.clear();
+        for (auto & item : input)
+        {
+            ds << item;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(std::to_string(ds.size()) + " bytes");
+}
+
+template <typename T, vector<T> (*make)()>
+static void bm_read(State & state)
+{
+    DataStream ds;
+    for (auto & item : make())
+    {
+        ds << item;
+    }
+    vector<T> output(4096);
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (auto & item : output)
+        {
+            ds >> item;
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(std::to_string(ds.size()) + " bytes");
+}
+
+BENCHMARK_TEMPLATE(bm_write, Point, points<Point>);
+BENCHMARK_TEMPLATE(bm_write, PointSchema, points<PointSchema>);
+BENCHMARK_TEMPLATE(bm_write, User, users<User>);
+BENCHMARK_TEMPLATE(bm_write, UserSchema, users<UserSchema>);
+BENCHMARK_TEMPLATE(bm_read, Point, points<Point>);
+BENCHMARK_TEMPLATE(bm_read, PointSchema, points<PointSchema>);
+BENCHMARK_TEMPLATE(bm_read, User, users<User>);
+BENCHMARK_TEMPLATE(bm_read, UserSchema, users<UserSchema>);
+
+BENCHMARK_MAIN();
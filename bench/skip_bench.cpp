@@ -0,0 +1,187 @@
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Address : public Serializable
+{
+public:
+    SERIALIZE(m_street, m_city, m_zip)
+
+    string m_street;
+    string m_city;
+    int32_t m_zip;
+};
+
+class Account : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_name, m_email, m_home, m_work, m_tags, m_scores, m_attrs, m_history, m_balance)
+
+    int64_t m_id;
+    string m_name;
+    string m_email;
+    Address m_home;
+    Address m_work;
+    vector<string> m_tags;
+    vector<int32_t> m_scores;
+    map<string, string> m_attrs;
+    vector<Address> m_history;
+    double m_balance;
+};
+
+static vector<Account> accounts()
+{
+    vector<Account> value(1024);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        Account & a = value[i];
+        a.m_id = i;
+        a.m_name = "account holder " + std::to_string(i);
+        a.m_email = "holder" + std::to_string(i) + "@example.com";
+        a.m_home = Address();
+        a.m_home.m_street = std::to_string(i) + " long street name avenue";
+        a.m_home.m_city = "springfield";
+        a.m_home.m_zip = 10000 + i;
+        a.m_work = a.m_home;
+        a.m_tags = { "retail", "priority", "newsletter", "region-" + std::to_string(i % 8) };
+        a.m_scores = vector<int32_t>(32, i);
+        a.m_attrs = { { "tier", "gold" }, { "segment", "consumer" }, { "source", "referral" } };
+        a.m_history = vector<Address>(4, a.m_home);
+        a.m_balance = i * 1.5;
+    }
+    return value;
+}
+
+static DataStream & encoded()
+{
+    static DataStream ds;
+    if (ds.size() == 0)
+    {
+        for (auto & item : accounts())
+        {
+            ds << item;
+        }
+    }
+    return ds;
+}
+
+// reading only the last field: range(0) 0 decodes every object in full,
+// 1 opens the object and skips the first nine fields
+static void bm_project_balance(State & state)
+{
+    DataStream & ds = encoded();
+    Account account;
+    double sum = 0;
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (int i = 0; i < 1024; i++)
+        {
+            if (state.range(0) == 0)
+            {
+                ds >> account;
+                sum += account.m_balance;
+                continue;
+            }
+            double balance = 0;
+            ds.open_object();
+            for (int f = 0; f < 9; f++)
+            {
+                ds.skip();
+            }
+            ds >> balance;
+            sum += balance;
+        }
+    }
+    do_not_optimize(sum);
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * 1024);
+}
+BENCHMARK(bm_project_balance)->arg(0)->arg(1);
+
+// walking over whole objects: range(0) 0 decodes, 1 skips by byte length
+static void bm_skip_objects(State & state)
+{
+    DataStream & ds = encoded();
+    Account account;
+    for (auto _ : state)
+    {
+        ds.reset();
+        for (int i = 0; i < 1024; i++)
+        {
+            if (state.range(0) == 0)
+            {
+                ds >> account;
+            }
+            else
+            {
+                ds.skip();
+            }
+        }
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_items_processed(state.iterations() * 1024);
+}
+BENCHMARK(bm_skip_objects)->arg(0)->arg(1);
+
+class Document : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_attrs, m_accounts, m_owner)
+
+    int64_t m_id;
+    map<string, string> m_attrs;
+    vector<Account> m_accounts;
+    string m_owner;
+};
+
+static DataStream & document(bool indexed)
+{
+    static DataStream ds[2];
+    if (ds[indexed].size() == 0)
+    {
+        Document doc;
+        doc.m_id = 1;
+        for (int i = 0; i < 4096; i++)
+        {
+            doc.m_attrs["attribute-" + std::to_string(i)] = "value " + std::to_string(i);
+        }
+        doc.m_accounts = accounts();
+        doc.m_owner = "owner";
+        ds[indexed].set_indexed(indexed);
+        ds[indexed] << doc;
+    }
+    return ds[indexed];
+}
+
+// one query against a large record: the owner field after a 4096 entry map,
+// then the balance of account 700; range(0) 0 plain, 1 with offset tables
+static void bm_seek_record(State & state)
+{
+    DataStream & ds = document(state.range(0));
+    string owner;
+    double balance = 0;
+    for (auto _ : state)
+    {
+        ds.seek(0);
+        ds.seek_field(3);
+        ds >> owner;
+        ds.seek(0);
+        ds.seek_field(2);
+        ds.seek_element(700);
+        ds.seek_field(9);
+        ds >> balance;
+    }
+    do_not_optimize(balance);
+    state.set_items_processed(state.iterations());
+    state.set_label(std::to_string(ds.size()) + " bytes");
+}
+BENCHMARK(bm_seek_record)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+#include <list>
+#include <string>
+#include <vector>
+using namespace std;
+
+#include <bench/Bench.h>
+#include <serialize/DataStream.h>
+using namespace yazi::serialize;
+using namespace yazi::bench;
+
+class Record : public Serializable
+{
+public:
+    SERIALIZE(m_id, m_count, m_offset, m_name, m_tags)
+
+    int64_t m_id;
+    int32_t m_count;
+    int32_t m_offset;
+    string m_name;
+    vector<string> m_tags;
+};
+
+static list<int32_t> small_ints()
+{
+    list<int32_t> value;
+    for (int i = 0; i < 4096; i++)
+    {
+        value.push_back(i % 100 - 50);
+    }
+    return value;
+}
+
+static list<int64_t> wide_ints()
+{
+    list<int64_t> value;
+    for (int i = 0; i < 4096; i++)
+    {
+        value.push_back((int64_t)i * 1000);
+    }
+    return value;
+}
+
+static vector<Record> records()
+{
+    vector<Record> value(1024);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        value[i].m_id = 100000 + i;
+        value[i].m_count = i % 17;
+        value[i].m_offset = -(int)i;
+        value[i].m_name = "record-" + std::to_string(i);
+        value[i].m_tags = { "alpha", "beta" };
+    }
+    return value;
+}
+
+// range(0): 0 = fixed width, 1 = compact varint
+template <typename T, T (*make)()>
+static void bm_write(State & state)
+{
+    T input = make();
+    DataStream ds;
+    ds.set_compact(state.range(0));
+    ds << input;
+    long bytes = ds.size();
+    for (auto _ : state)
+    {
+        ds.clear();
+        ds << input;
+    }
+    state.set_bytes_processed(state.iterations() * bytes);
+    state.set_label(std::to_string(bytes) + " bytes");
+}
+BENCHMARK_TEMPLATE(bm_write, list<int32_t>, small_ints)->arg(0)->arg(1);
+BENCHMARK_TEMPLATE(bm_write, list<int64_t>, wide_ints)->arg(0)->arg(1);
+BENCHMARK_TEMPLATE(bm_write, vector<Record>, records)->arg(0)->arg(1);
+
+template <typename T, T (*make)()>
+static void bm_read(State & state)
+{
+    DataStream ds;
+    ds.set_compact(state.range(0));
+    ds << make();
+    T output;
+    for (auto _ : state)
+    {
+        ds.reset();
+        ds >> output;
+    }
+    state.set_bytes_processed(state.iterations() * ds.size());
+    state.set_label(std::to_string(ds.size()) + " bytes");
+}
+BENCHMARK_TEMPLATE(bm_read, list<int32_t>, small_ints)->arg(0)->arg(1);
+BENCHMARK_TEMPLATE(bm_read, list<int64_t>, wide_ints)->arg(0)->arg(1);
+BENCHMARK_TEMPLATE(bm_read, vector<Record>, records)->arg(0)->arg(1);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,100 @@
+#include <serialize/Arena.h>
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+using namespace yazi::serialize;
+
+static thread_local Arena * current_arena = NULL;
+
+Arena::Arena(size_t block) : m_ptr(NULL), m_end(NULL), m_block(block), m_used(0)
+{
+}
+
+Arena::~Arena()
+{
+    for (auto block : m_blocks)
+    {
+        std::free(block);
+    }
+}
+
+void * Arena::allocate(size_t size, size_t align)
+{
+    size_t pad = (align - (size_t)m_ptr % align) % align;
+    if (m_ptr == NULL || size + pad > (size_t)(m_end - m_ptr))
+    {
+        grow(size + align);
+        pad = (align - (size_t)m_ptr % align) % align;
+    }
+    char * p = m_ptr + pad;
+    m_ptr = p + size;
+    m_used += size + pad;
+    return p;
+}
+
+void Arena::grow(size_t size)
+{
+    size_t len = m_block;
+    if (!m_sizes.empty())
+    {
+        len = m_sizes.back() * 2;
+    }
+    while (len < size)
+    {
+        len *= 2;
+    }
+    char * block = (char *)std::malloc(len);
+    if (block == NULL)
+    {
+        throw std::bad_alloc();
+    }
+    m_blocks.push_back(block);
+    m_sizes.push_back(len);
+    m_ptr = block;
+    m_end = block + len;
+}
+
+void Arena::reset()
+{
+    // a request that spilled into several blocks gets one block big enough
+    // for all of it next time, so the steady state needs no malloc at all
+    if (m_blocks.size() > 1)
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < m_blocks.size(); i++)
+        {
+            total += m_sizes[i];
+            std::free(m_blocks[i]);
+        }
+        m_blocks.clear();
+        m_sizes.clear();
+        m_block = std::max(m_block, total);
+        m_ptr = NULL;
+        m_end = NULL;
+    }
+    else if (!m_blocks.empty())
+    {
+        m_ptr = m_blocks[0];
+    }
+    m_used = 0;
+}
+
+size_t Arena::used() const
+{
+    return m_used;
+}
+
+Arena * Arena::current()
+{
+    return current_arena;
+}
+
+Arena::Scope::Scope(Arena & arena) : m_prev(current_arena)
+{
+    current_arena = &arena;
+}
+
+Arena::Scope::~Scope()
+{
+    current_arena = m_prev;
+}
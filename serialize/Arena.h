@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace yazi {
+namespace serialize {
+
+// bump allocator for request-scoped decoding: allocations are never freed one
+// by one, reset() releases everything at once and keeps the memory for reuse
+class Arena
+{
+public:
+    Arena(size_t block = 4096);
+    ~Arena();
+
+    void * allocate(size_t size, size_t align);
+    void reset();
+    size_t used() const;
+
+    // arena used by default-constructed ArenaAllocators on this thread
+    static Arena * current();
+
+    class Scope
+    {
+    public:
+        Scope(Arena & arena);
+        ~Scope();
+
+    private:
+        Arena * m_prev;
+    };
+
+private:
+    Arena(const Arena &);
+    Arena & operator = (const Arena &);
+
+    void grow(size_t size);
+
+private:
+    std::vector<char *> m_blocks;
+    std::vector<size_t> m_sizes;
+    char * m_ptr;
+    char * m_end;
+    size_t m_block;
+    size_t m_used;
+};
+
+// allocator handing out arena memory, falls back to the heap without an arena
+template <typename T>
+class ArenaAllocator
+{
+public:
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+
+    ArenaAllocator() : m_arena(Arena::current()) {}
+    ArenaAllocator(Arena * arena) : m_arena(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> & other) : m_arena(other.arena()) {}
+
+    T * allocate(size_t n)
+    {
+        if (m_arena == NULL)
+        {
+            return static_cast<T *>(::operator new(n * sizeof(T)));
+        }
+        return static_cast<T *>(m_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T * p, size_t n)
+    {
+        if (m_arena == NULL)
+        {
+            ::operator delete(p);
+        }
+    }
+
+    Arena * arena() const { return m_arena; }
+
+private:
+    Arena * m_arena;
+};
+
+template <typename T, typename U>
+bool operator == (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b)
+{
+    return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator != (const ArenaAllocator<T> & a, const ArenaAllocator<U> & b)
+{
+    return a.arena() != b.arena();
+}
+
+typedef std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>> ArenaString;
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+}
+}
@@ -0,0 +1,42 @@
+#include <serialize/Buffer.h>
+using namespace yazi::serialize;
+
+BufferPool::BufferPool(int max_buffers, int max_capacity) : m_max_buffers(max_buffers), m_max_capacity(max_capacity)
+{
+    m_buffers.reserve(max_buffers);
+}
+
+BufferPool::~BufferPool()
+{
+}
+
+void BufferPool::acquire(Buffer & buf)
+{
+    if (m_buffers.empty())
+    {
+        return;
+    }
+    buf.swap(m_buffers.back());
+    m_buffers.pop_back();
+}
+
+void BufferPool::release(Buffer & buf)
+{
+    if (buf.capacity() == 0 || (int)m_buffers.size() >= m_max_buffers || buf.capacity() > (size_t)m_max_capacity)
+    {
+        return;
+    }
+    m_buffers.push_back(Buffer());
+    m_buffers.back().swap(buf);
+}
+
+int BufferPool::size() const
+{
+    return m_buffers.size();
+}
+
+BufferPool & BufferPool::local()
+{
+    static thread_local BufferPool pool;
+    return pool;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace yazi {
+namespace serialize {
+
+// std::allocator that default-initializes on resize, so growing a byte buffer
+// reserves memory without zero-filling it
+template <typename T>
+class BufferAllocator : public std::allocator<T>
+{
+public:
+    template <typename U>
+    struct rebind
+    {
+        typedef BufferAllocator<U> other;
+    };
+
+    BufferAllocator() {}
+
+    template <typename U>
+    BufferAllocator(const BufferAllocator<U> &) {}
+
+    template <typename U>
+    void construct(U * p)
+    {
+        ::new ((void *)p) U;
+    }
+
+    template <typename U, typename ...Args>
+    void construct(U * p, Args&&... args)
+    {
+        ::new ((void *)p) U(std::forward<Args>(args)...);
+    }
+};
+typedef std::vector<char, BufferAllocator<char>> Buffer;
+
+// recycles stream buffers so short-lived streams keep their capacity instead
+// of going back to the heap; a pool is not thread safe, use one per thread
+class BufferPool
+{
+public:
+    BufferPool(int max_buffers = 16, int max_capacity = 4 << 20);
+    ~BufferPool();
+
+    // moves a pooled buffer into buf, buf is left empty if the pool is
+    void acquire(Buffer & buf);
+
+    // keeps buf's storage for reuse unless the pool is full or buf is oversized
+    void release(Buffer & buf);
+
+    int size() const;
+
+    static BufferPool & local();
+
+private:
+    std::vector<Buffer> m_buffers;
+    int m_max_buffers;
+    int m_max_capacity;
+};
+
+}
+}
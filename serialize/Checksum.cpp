@@ -0,0 +1,58 @@
+#include <serialize/Checksum.h>
+#include <cstring>
+using namespace yazi::serialize;
+
+// slicing-by-8 tables, table[k][b] is the crc of byte b followed by k zeros
+struct Crc32cTable
+{
+    uint32_t table[8][256];
+
+    Crc32cTable()
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; k++)
+            {
+                crc = (crc >> 1) ^ (0x82f63b78 & (0 - (crc & 1)));
+            }
+            table[0][i] = crc;
+        }
+        for (int k = 1; k < 8; k++)
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xff];
+            }
+        }
+    }
+};
+
+uint32_t yazi::serialize::crc32c(const char * data, int len, uint32_t crc)
+{
+    static const Crc32cTable crc_table;
+    const uint32_t (*t)[256] = crc_table.table;
+    const unsigned char * p = (const unsigned char *)data;
+    crc = ~crc;
+    while (len >= 8)
+    {
+        uint32_t lo;
+        uint32_t hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        lo = __builtin_bswap32(lo);
+        hi = __builtin_bswap32(hi);
+#endif
+        lo ^= crc;
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+              t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        p += 8;
+        len -= 8;
+    }
+    while (len-- > 0)
+    {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xff];
+    }
+    return ~crc;
+}
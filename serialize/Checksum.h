@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+namespace yazi {
+namespace serialize {
+
+// CRC-32C (Castagnoli), crc is the value of the preceding bytes when a
+// checksum is computed over several blocks
+uint32_t crc32c(const char * data, int len, uint32_t crc = 0);
+
+}
+}
@@ -0,0 +1,526 @@
+#include <serialize/Compress.h>
+#include <serialize/Checksum.h>
+#include <serialize/Endian.h>
+#include <serialize/Parallel.h>
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <vector>
+using namespace yazi::serialize;
+
+static const char kMagic[8] = { (char)0xb7, 'Y', 'Z', 'B', 'L', 'K', 1, 0 };
+static const int kHeader = 12;
+static const uint32_t kStored = 0x80000000;
+static const int kMaxBlock = 1 << 30;
+
+static void put32(char * buf, uint32_t value)
+{
+    if (kHostBigEndian)
+    {
+        value = byteswap(value);
+    }
+    std::memcpy(buf, &value, 4);
+}
+
+static uint32_t get32(const char * buf)
+{
+    uint32_t value;
+    std::memcpy(&value, buf, 4);
+    if (kHostBigEndian)
+    {
+        value = byteswap(value);
+    }
+    return value;
+}
+
+// LZ4 block format: each sequence is a token whose high nibble is the
+// literal length and low nibble the match length less 4, 15 meaning more
+// length bytes follow, then the literals, then a 2 byte offset back into
+// the output; the last sequence has literals only and the last 5 bytes of
+// a block are always literals
+
+static const int kHashLog = 14;
+static const int kMinMatch = 4;
+static const int kLastLiterals = 5;
+static const int kMatchStart = 12;
+
+static uint32_t load32(const uint8_t * p)
+{
+    uint32_t value;
+    std::memcpy(&value, p, 4);
+    return value;
+}
+
+static uint64_t load64(const uint8_t * p)
+{
+    uint64_t value;
+    std::memcpy(&value, p, 8);
+    return value;
+}
+
+static uint32_t hash4(uint32_t seq)
+{
+    return (seq * 2654435761u) >> (32 - kHashLog);
+}
+
+static uint8_t * put_length(uint8_t * out, int len)
+{
+    while (len >= 255)
+    {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = (uint8_t)len;
+    return out;
+}
+
+static uint8_t * put_literals(uint8_t * out, uint8_t * token, const uint8_t * literals, int len)
+{
+    *token = (uint8_t)(std::min(len, 15) << 4);
+    if (len >= 15)
+    {
+        out = put_length(out, len - 15);
+    }
+    std::memcpy(out, literals, len);
+    return out + len;
+}
+
+// the number of equal bytes at a and b, stopping at limit
+static const uint8_t * match_end(const uint8_t * a, const uint8_t * b, const uint8_t * limit)
+{
+    while (a + 8 <= limit)
+    {
+        uint64_t diff = load64(a) ^ load64(b);
+        if (diff != 0)
+        {
+            return a + (kHostBigEndian ? __builtin_clzll(diff) : __builtin_ctzll(diff)) / 8;
+        }
+        a += 8;
+        b += 8;
+    }
+    while (a < limit && *a == *b)
+    {
+        a++;
+        b++;
+    }
+    return a;
+}
+
+int yazi::serialize::lz_bound(int len)
+{
+    return len + len / 255 + 16;
+}
+
+int yazi::serialize::lz_compress(const char * src, int len, char * dst)
+{
+    const uint8_t * in = (const uint8_t *)src;
+    const uint8_t * end = in + len;
+    const uint8_t * anchor = in;
+    uint8_t * out = (uint8_t *)dst;
+    if (len > kMatchStart)
+    {
+        std::vector<uint32_t> table(1 << kHashLog, 0);
+        const uint8_t * limit = end - kMatchStart;
+        const uint8_t * match_limit = end - kLastLiterals;
+        const uint8_t * ip = in;
+        while (ip < limit)
+        {
+            uint32_t seq = load32(ip);
+            uint32_t h = hash4(seq);
+            const uint8_t * ref = in + table[h];
+            table[h] = ip - in;
+            if (ref >= ip || ip - ref > 65535 || load32(ref) != seq)
+            {
+                // the longer nothing matches, the bigger the steps
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+            while (ip > anchor && ref > in && ip[-1] == ref[-1])
+            {
+                ip--;
+                ref--;
+            }
+            const uint8_t * mend = match_end(ip + kMinMatch, ref + kMinMatch, match_limit);
+            uint8_t * token = out++;
+            out = put_literals(out, token, anchor, ip - anchor);
+            int offset = ip - ref;
+            *out++ = (uint8_t)offset;
+            *out++ = (uint8_t)(offset >> 8);
+            int mlen = mend - ip - kMinMatch;
+            *token |= (uint8_t)std::min(mlen, 15);
+            if (mlen >= 15)
+            {
+                out = put_length(out, mlen - 15);
+            }
+            ip = mend;
+            anchor = ip;
+            if (ip < limit)
+            {
+                table[hash4(load32(ip - 2))] = ip - 2 - in;
+            }
+        }
+    }
+    uint8_t * token = out++;
+    out = put_literals(out, token, anchor, end - anchor);
+    return out - (uint8_t *)dst;
+}
+
+// reads a length continued in 255 steps, false if the input ends first
+static bool get_length(const uint8_t *& ip, const uint8_t * end, size_t & len)
+{
+    uint8_t b;
+    do
+    {
+        if (ip >= end)
+        {
+            return false;
+        }
+        b = *ip++;
+        len += b;
+    }
+    while (b == 255);
+    return true;
+}
+
+int yazi::serialize::lz_decompress(const char * src, int len, char * dst, int cap)
+{
+    const uint8_t * ip = (const uint8_t *)src;
+    const uint8_t * iend = ip + len;
+    uint8_t * op = (uint8_t *)dst;
+    uint8_t * oend = op + cap;
+    while (ip < iend)
+    {
+        int token = *ip++;
+        size_t lit = token >> 4;
+        if (lit == 15 && !get_length(ip, iend, lit))
+        {
+            return -1;
+        }
+        if (lit > (size_t)(iend - ip) || lit > (size_t)(oend - op))
+        {
+            return -1;
+        }
+        std::memcpy(op, ip, lit);
+        op += lit;
+        ip += lit;
+        if (ip == iend)
+        {
+            break;
+        }
+        if (iend - ip < 2)
+        {
+            return -1;
+        }
+        size_t offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        size_t mlen = token & 15;
+        if (mlen == 15 && !get_length(ip, iend, mlen))
+        {
+            return -1;
+        }
+        mlen += kMinMatch;
+        if (offset == 0 || offset > (size_t)(op - (uint8_t *)dst) || mlen > (size_t)(oend - op))
+        {
+            return -1;
+        }
+        const uint8_t * ref = op - offset;
+        if (offset >= 8 && (size_t)(oend - op) >= mlen + 8)
+        {
+            // 8 bytes at a time may run past the match, never past the output
+            for (size_t i = 0; i < mlen; i += 8)
+            {
+                std::memcpy(op + i, ref + i, 8);
+            }
+        }
+        else
+        {
+            for (size_t i = 0; i < mlen; i++)
+            {
+                op[i] = ref[i];
+            }
+        }
+        op += mlen;
+    }
+    return op - (uint8_t *)dst;
+}
+
+// appends one block, header and stored bytes, to out
+static void encode_block(const char * data, int len, Codec codec, Buffer & out)
+{
+    size_t pos = out.size();
+    out.resize(pos + kHeader + (codec == LzCodec ? lz_bound(len) : len));
+    char * stored = &out[pos + kHeader];
+    uint32_t n = len | kStored;
+    if (codec == LzCodec)
+    {
+        int packed = lz_compress(data, len, stored);
+        if (packed < len)
+        {
+            n = packed;
+        }
+    }
+    if (n & kStored)
+    {
+        std::memcpy(stored, data, len);
+    }
+    int size = n & ~kStored;
+    put32(&out[pos], len);
+    put32(&out[pos + 4], n);
+    put32(&out[pos + 8], crc32c(stored, size));
+    out.resize(pos + kHeader + size);
+}
+
+// whether a header's raw length is one its stored bytes could produce: a
+// stored block is its raw bytes, and an LZ sequence expands at most 255 fold
+// (a length byte of 255 buys 255 bytes of match), so a damaged header cannot
+// make the reader allocate far more than the input could fill
+static bool block_fits(int raw, uint32_t n)
+{
+    int64_t size = n & ~kStored;
+    if (raw <= 0 || raw > kMaxBlock)
+    {
+        return false;
+    }
+    if (n & kStored)
+    {
+        return size == raw;
+    }
+    return size > 0 && size <= lz_bound(raw) && raw <= size * 255;
+}
+
+// checks the stored bytes and decodes them into exactly raw bytes at dst
+static bool decode_block(const char * stored, uint32_t n, uint32_t crc, char * dst, int raw)
+{
+    int size = n & ~kStored;
+    if (crc32c(stored, size) != crc)
+    {
+        return false;
+    }
+    if (n & kStored)
+    {
+        if (size != raw)
+        {
+            return false;
+        }
+        std::memcpy(dst, stored, size);
+        return true;
+    }
+    return lz_decompress(stored, size, dst, raw) == raw;
+}
+
+bool yazi::serialize::is_compressed(const char * data, int64_t len)
+{
+    return len >= (int64_t)sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+void yazi::serialize::compress(const char * data, int64_t len, Buffer & out, Codec codec, int block, int threads)
+{
+    block = std::max(1, std::min(block, kMaxBlock));
+    int64_t blocks = (len + block - 1) / block;
+    std::vector<Buffer> parts(threads > 1 ? blocks : 0);
+    if (threads > 1)
+    {
+        parallel_for(blocks, threads, [&](int i)
+        {
+            int64_t first = (int64_t)i * block;
+            encode_block(data + first, std::min<int64_t>(block, len - first), codec, parts[i]);
+        });
+    }
+    out.insert(out.end(), kMagic, kMagic + sizeof(kMagic));
+    for (int64_t i = 0; i < blocks; i++)
+    {
+        if (threads > 1)
+        {
+            out.insert(out.end(), parts[i].begin(), parts[i].end());
+            continue;
+        }
+        int64_t first = (int64_t)i * block;
+        encode_block(data + first, std::min<int64_t>(block, len - first), codec, out);
+    }
+    char end[kHeader] = { 0 };
+    out.insert(out.end(), end, end + kHeader);
+}
+
+bool yazi::serialize::decompress(const char * data, int64_t len, Buffer & out, int threads)
+{
+    struct Block
+    {
+        const char * stored;
+        uint32_t n;
+        uint32_t crc;
+        int raw;
+        int64_t pos;
+    };
+    if (!is_compressed(data, len))
+    {
+        return false;
+    }
+    // the headers say where every block goes, so the blocks themselves can
+    // be decoded in any order
+    std::vector<Block> blocks;
+    int64_t total = 0;
+    const char * p = data + sizeof(kMagic);
+    const char * end = data + len;
+    while (true)
+    {
+        if (end - p < kHeader)
+        {
+            return false;
+        }
+        Block b;
+        b.raw = get32(p);
+        b.n = get32(p + 4);
+        b.crc = get32(p + 8);
+        b.stored = p + kHeader;
+        b.pos = total;
+        if (b.raw == 0)
+        {
+            break;
+        }
+        int64_t size = b.n & ~kStored;
+        if (!block_fits(b.raw, b.n) || size > end - b.stored)
+        {
+            return false;
+        }
+        total += b.raw;
+        blocks.push_back(b);
+        p = b.stored + size;
+    }
+    try
+    {
+        out.resize(total);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return false;
+    }
+    std::vector<char> ok(blocks.size(), 0);
+    parallel_for(blocks.size(), threads, [&](int i)
+    {
+        const Block & b = blocks[i];
+        ok[i] = decode_block(b.stored, b.n, b.crc, &out[b.pos], b.raw);
+    });
+    return std::find(ok.begin(), ok.end(), 0) == ok.end();
+}
+
+CompressSink::CompressSink(Sink * sink, Codec codec, int block)
+    : m_sink(sink), m_codec(codec), m_block(std::max(1, std::min(block, kMaxBlock))), m_size(0), m_started(false), m_ok(true)
+{
+}
+
+bool CompressSink::write(const char * data, int len)
+{
+    while (len > 0)
+    {
+        // whole blocks straight from the caller's bytes, the rest is gathered
+        if (m_size == 0 && len >= m_block)
+        {
+            m_ok = emit(data, m_block) && m_ok;
+            data += m_block;
+            len -= m_block;
+            continue;
+        }
+        if (m_pending.size() < (size_t)m_block)
+        {
+            m_pending.resize(m_block);
+        }
+        int n = std::min(len, m_block - m_size);
+        std::memcpy(&m_pending[m_size], data, n);
+        m_size += n;
+        data += n;
+        len -= n;
+        if (m_size == m_block)
+        {
+            m_ok = emit(m_pending.data(), m_size) && m_ok;
+            m_size = 0;
+        }
+    }
+    return m_ok;
+}
+
+bool CompressSink::finish()
+{
+    if (m_size > 0 || !m_started)
+    {
+        m_ok = emit(m_pending.data(), m_size) && m_ok;
+        m_size = 0;
+    }
+    char end[kHeader] = { 0 };
+    m_ok = m_sink->write(end, kHeader) && m_ok;
+    return m_ok;
+}
+
+bool CompressSink::emit(const char * data, int len)
+{
+    m_scratch.clear();
+    if (!m_started)
+    {
+        m_scratch.insert(m_scratch.end(), kMagic, kMagic + sizeof(kMagic));
+        m_started = true;
+    }
+    if (len > 0)
+    {
+        encode_block(data, len, m_codec, m_scratch);
+    }
+    return m_sink->write(m_scratch.data(), m_scratch.size());
+}
+
+DecompressSink::DecompressSink(Sink * sink) : m_sink(sink), m_started(false), m_finished(false), m_ok(true)
+{
+}
+
+bool DecompressSink::write(const char * data, int len)
+{
+    if (!m_ok || m_finished)
+    {
+        return m_ok;
+    }
+    m_input.insert(m_input.end(), data, data + len);
+    size_t used = 0;
+    if (!m_started)
+    {
+        if (m_input.size() < sizeof(kMagic))
+        {
+            return true;
+        }
+        if (!is_compressed(m_input.data(), sizeof(kMagic)))
+        {
+            m_ok = false;
+            return false;
+        }
+        m_started = true;
+        used = sizeof(kMagic);
+    }
+    while (m_ok && m_input.size() - used >= (size_t)kHeader)
+    {
+        const char * p = &m_input[used];
+        int raw = get32(p);
+        uint32_t n = get32(p + 4);
+        if (raw == 0)
+        {
+            m_finished = true;
+            used = m_input.size();
+            break;
+        }
+        size_t size = n & ~kStored;
+        if (!block_fits(raw, n))
+        {
+            m_ok = false;
+            break;
+        }
+        if (m_input.size() - used < kHeader + size)
+        {
+            break;
+        }
+        m_output.resize(raw);
+        m_ok = decode_block(p + kHeader, n, get32(p + 8), m_output.data(), raw) && m_sink->write(m_output.data(), raw);
+        used += kHeader + size;
+    }
+    m_input.erase(m_input.begin(), m_input.begin() + used);
+    return m_ok;
+}
+
+bool DecompressSink::finished() const
+{
+    return m_finished;
+}
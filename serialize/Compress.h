@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+
+#include <serialize/Buffer.h>
+#include <serialize/Sink.h>
+
+namespace yazi {
+namespace serialize {
+
+// block compressed container: an 8 byte magic, then blocks that are each
+// compressed on their own, so they can be written as a stream and decoded
+// in parallel; a block is a 12 byte header of little endian words, the raw
+// length, the stored length with the top bit set when the block is kept
+// uncompressed, and a CRC-32C of the stored bytes, then the stored bytes;
+// a block with raw length 0 ends the container
+enum Codec
+{
+    StoreCodec,
+    LzCodec
+};
+
+bool is_compressed(const char * data, int64_t len);
+
+// appends the container holding data to out, blocks are compressed on up
+// to threads threads
+void compress(const char * data, int64_t len, Buffer & out, Codec codec = LzCodec, int block = 64 << 10, int threads = 1);
+
+// replaces out with the contents of a container, false if it is malformed,
+// fails its checksums or is cut short
+bool decompress(const char * data, int64_t len, Buffer & out, int threads = 1);
+
+// the LZ codec on its own, an LZ77 in the LZ4 block format: lz_compress
+// writes at most lz_bound(len) bytes, lz_decompress returns the decoded
+// length or -1 when src is not a valid block that fits in cap bytes
+int lz_bound(int len);
+int lz_compress(const char * src, int len, char * dst);
+int lz_decompress(const char * src, int len, char * dst, int cap);
+
+// compresses everything written to it into the sink, a block at a time;
+// finish writes the last partial block and the end of the container
+class CompressSink : public Sink
+{
+public:
+    CompressSink(Sink * sink, Codec codec = LzCodec, int block = 64 << 10);
+
+    virtual bool write(const char * data, int len);
+    bool finish();
+
+private:
+    bool emit(const char * data, int len);
+
+private:
+    Sink * m_sink;
+    Codec m_codec;
+    int m_block;
+    Buffer m_pending;
+    int m_size;
+    Buffer m_scratch;
+    bool m_started;
+    bool m_ok;
+};
+
+// the other way round: takes a container in pieces of any size and passes
+// each block on to the sink as soon as it is whole
+class DecompressSink : public Sink
+{
+public:
+    DecompressSink(Sink * sink);
+
+    virtual bool write(const char * data, int len);
+
+    // whether the end of the container has been seen
+    bool finished() const;
+
+private:
+    Sink * m_sink;
+    Buffer m_input;
+    Buffer m_output;
+    bool m_started;
+    bool m_finished;
+    bool m_ok;
+};
+
+}
+}
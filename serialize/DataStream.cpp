@@ -1,27 +1,97 @@
 #include <serialize/DataStream.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <thread>
 using namespace yazi::serialize;
 
-DataStream::DataStream() : m_pos(0)
+static inline uint64_t zigzag(int64_t value)
 {
-    m_byteorder = byteorder();
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
 }
 
-DataStream::DataStream(const string & str) : m_pos(0)
+static inline int64_t unzigzag(uint64_t value)
 {
-    m_byteorder = byteorder();
-    m_buf.clear();
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static inline int encode_varint(char * buf, uint64_t value)
+{
+    int len = 0;
+    while (value >= 0x80)
+    {
+        buf[len++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    buf[len++] = (char)value;
+    return len;
+}
+
+// strings up to kInternMax bytes are interned, a reference reaches back at
+// most kInternWindow bytes so it never takes more than three varint bytes
+static const int kInternMax = 64;
+static const int kInternWindow = 64 << 10;
+static const int kInternSlots = 4096;
+
+DataStream::DataStream() : m_pool(NULL), m_size(0), m_view(NULL), m_viewlen(0), m_pos(0), m_compact(false), m_indexed(false), m_interned(false), m_threads(1), m_grain(4096), m_gather(0), m_borrowed(0), m_sink(NULL), m_flushed(0), m_hold(-1), m_open(0), m_sink_ok(true), m_unsized(false), m_incremental(false), m_partial(false), m_depth(0)
+{
+    m_byteorder = ByteOrder::LittleEndian;
+}
+
+DataStream::DataStream(const string & str) : m_pool(NULL), m_size(0), m_view(NULL), m_viewlen(0), m_pos(0), m_compact(false), m_indexed(false), m_interned(false), m_threads(1), m_grain(4096), m_gather(0), m_borrowed(0), m_sink(NULL), m_flushed(0), m_hold(-1), m_open(0), m_sink_ok(true), m_unsized(false), m_incremental(false), m_partial(false), m_depth(0)
+{
+    m_byteorder = ByteOrder::LittleEndian;
     reserve(str.size());
     write(str.data(), str.size());
 }
 
+DataStream::DataStream(BufferPool * pool) : m_pool(pool), m_size(0), m_view(NULL), m_viewlen(0), m_pos(0), m_compact(false), m_indexed(false), m_interned(false), m_threads(1), m_grain(4096), m_gather(0), m_borrowed(0), m_sink(NULL), m_flushed(0), m_hold(-1), m_open(0), m_sink_ok(true), m_unsized(false), m_incremental(false), m_partial(false), m_depth(0)
+{
+    m_byteorder = ByteOrder::LittleEndian;
+    if (m_pool != NULL)
+    {
+        m_pool->acquire(m_buf);
+    }
+}
+
+DataStream::DataStream(Buffer && buf) : m_pool(NULL), m_size(0), m_view(NULL), m_viewlen(0), m_pos(0), m_compact(false), m_indexed(false), m_interned(false), m_threads(1), m_grain(4096), m_gather(0), m_borrowed(0), m_sink(NULL), m_flushed(0), m_hold(-1), m_open(0), m_sink_ok(true), m_unsized(false), m_incremental(false), m_partial(false), m_depth(0)
+{
+    m_byteorder = ByteOrder::LittleEndian;
+    m_buf.swap(buf);
+    m_size = m_buf.size();
+}
+
 DataStream::~DataStream()
 {
+    if (m_sink != NULL)
+    {
+        flush();
+    }
+    if (m_pool != NULL)
+    {
+        m_pool->release(m_buf);
+    }
 }
 
-void DataStream::reserve(int len)
+void DataStream::reserve(int64_t len)
 {
-    int size = m_buf.size();
-    int cap = m_buf.capacity();
+    if (m_view != NULL)
+    {
+        m_buf.assign(m_view, m_view + m_viewlen);
+        m_size = m_viewlen;
+        m_view = NULL;
+        m_viewlen = 0;
+        m_mapping.reset();
+    }
+    if (m_sink != NULL && m_size + len > (int64_t)m_buf.size())
+    {
+        flush();
+    }
+    int64_t size = m_size;
+    int64_t cap = m_buf.size();
     if (size + len > cap)
     {
         while (size + len > cap)
@@ -35,412 +105,1919 @@ void DataStream::reserve(int len)
                 cap *= 2;
             }
         }
-        m_buf.reserve(cap);
+        m_buf.resize(cap);
+    }
+}
+
+void DataStream::show() const
+{
+    DataStream reader;
+    reader.attach(data(), size());
+    reader.m_compact = m_compact;
+    reader.m_byteorder = m_byteorder;
+    std::cout << "data size = " << size() << std::endl;
+    while (reader.m_pos < reader.size())
+    {
+        bool ok = true;
+        int64_t len = 0;
+        switch ((DataType)reader.data()[reader.m_pos])
+        {
+        case DataType::BOOL:
+        {
+            bool value = false;
+            ok = reader.read(value);
+            std::cout << (value ? "true" : "false");
+            break;
+        }
+        case DataType::CHAR:
+        {
+            char value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::INT32:
+        {
+            int32_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::INT64:
+        {
+            int64_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::INT8:
+        {
+            int8_t value = 0;
+            ok = reader.read(value);
+            std::cout << (int)value;
+            break;
+        }
+        case DataType::UINT8:
+        {
+            uint8_t value = 0;
+            ok = reader.read(value);
+            std::cout << (int)value;
+            break;
+        }
+        case DataType::INT16:
+        {
+            int16_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::UINT16:
+        {
+            uint16_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::UINT32:
+        {
+            uint32_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::UINT64:
+        {
+            uint64_t value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::FLOAT:
+        {
+            float value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::DOUBLE:
+        {
+            double value = 0;
+            ok = reader.read(value);
+            std::cout << value;
+            break;
+        }
+        case DataType::STRING:
+        case DataType::STRINGREF:
+        {
+            StringView value;
+            ok = reader.read(value);
+            std::cout << value.str();
+            break;
+        }
+        case DataType::VECTOR:
+        case DataType::LIST:
+        case DataType::MAP:
+        case DataType::SET:
+        case DataType::OBJECT:
+            ++reader.m_pos;
+            ok = reader.read_length(len);
+            break;
+        case DataType::INDEX:
+            reader.m_pos += 2;
+            ok = reader.read_length(len) && reader.read_length(len);
+            reader.m_pos += len * 4;
+            break;
+        case DataType::ARRAY:
+        {
+            int width = 1;
+            switch ((DataType)reader.data()[reader.m_pos + 1])
+            {
+            case DataType::INT16:
+            case DataType::UINT16:
+                width = 2;
+                break;
+            case DataType::INT32:
+            case DataType::UINT32:
+            case DataType::FLOAT:
+                width = 4;
+                break;
+            case DataType::INT64:
+            case DataType::UINT64:
+            case DataType::DOUBLE:
+                width = 8;
+                break;
+            default:
+                break;
+            }
+            reader.m_pos += 2;
+            ok = reader.read_length(len);
+            reader.m_pos += len * width;
+            break;
+        }
+        default:
+            ++reader.m_pos;
+            break;
+        }
+        if (!ok)
+        {
+            throw std::logic_error("parse data error");
+        }
+    }
+    std::cout << std::endl;
+}
+
+void DataStream::write(const char * data, int64_t len)
+{
+    if (len <= 0)
+    {
+        return;
+    }
+    if (m_sink != NULL && m_hold < 0 && len >= (int64_t)m_buf.size())
+    {
+        // large blocks bypass the buffer instead of growing it
+        flush();
+        write_sink(data, len);
+        return;
+    }
+    reserve(len);
+    std::memcpy(m_buf.data() + m_size, data, len);
+    m_size += len;
+}
+
+// copies a block of fixed-width values in wire byte order, swapping piece by
+// piece so a streaming buffer never has to hold the whole block; a block
+// that needs no swapping may be borrowed
+void DataStream::write_array(const char * data, int64_t len, int width)
+{
+    if (!swapped())
+    {
+        write_payload(data, len);
+        return;
+    }
+    const int piece = 4096 * width;
+    while (len > 0)
+    {
+        int64_t n = std::min<int64_t>(len, piece);
+        reserve(n);
+        swap_bytes(m_buf.data() + m_size, data, n, width);
+        m_size += n;
+        data += n;
+        len -= n;
+    }
+}
+
+// a payload large enough is borrowed rather than copied when gathering
+void DataStream::write_payload(const char * data, int64_t len)
+{
+    if (m_gather <= 0 || len < m_gather || m_sink != NULL)
+    {
+        write(data, len);
+        return;
+    }
+    if (m_view != NULL)
+    {
+        reserve(0);
+    }
+    m_segments.push_back(Segment{ m_size, data, len, m_borrowed });
+    m_borrowed += len;
+}
+
+void DataStream::write(const char * value)
+{
+    int64_t len = strlen(value);
+    if (m_interned && write_ref(value, len))
+    {
+        return;
+    }
+    char type = DataType::STRING;
+    write((char *)&type, sizeof(char));
+    write_length(len);
+    write_payload(value, len);
+}
+
+void DataStream::write(const string & value)
+{
+    int64_t len = value.size();
+    if (m_interned && write_ref(value.data(), len))
+    {
+        return;
+    }
+    char type = DataType::STRING;
+    write((char *)&type, sizeof(char));
+    write_length(len);
+    write_payload(value.data(), len);
+}
+
+void DataStream::write(const StringView & value)
+{
+    int64_t len = value.size();
+    if (m_interned && write_ref(value.data(), len))
+    {
+        return;
+    }
+    char type = DataType::STRING;
+    write((char *)&type, sizeof(char));
+    write_length(len);
+    write_payload(value.data(), len);
+}
+
+void DataStream::write(const Serializable & value)
+{
+    value.serialize(*this);
+}
+
+// writes a reference when the string is in the window and the reference is
+// the shorter of the two, otherwise records where the copy about to be
+// written starts
+bool DataStream::write_ref(const char * data, int64_t len)
+{
+    if (len > kInternMax)
+    {
+        return false;
+    }
+    if (m_strings.empty())
+    {
+        m_strings.resize(kInternSlots);
+        forget_strings();
+    }
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (int64_t i = 0; i < len; i++)
+    {
+        hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+    }
+    Interned & slot = m_strings[hash & (kInternSlots - 1)];
+    int64_t pos = m_flushed + m_size + m_borrowed;
+    if (slot.pos >= 0 && pos - slot.pos <= kInternWindow && slot.text.size() == (size_t)len && std::memcmp(slot.text.data(), data, len) == 0)
+    {
+        char buf[10];
+        // a tagged length is an INT32 tag and four bytes
+        int inline_len = 1 + (m_compact ? encode_varint(buf, len) : 5) + len;
+        if (1 + encode_varint(buf, pos - slot.pos) < inline_len)
+        {
+            write_varint(DataType::STRINGREF, pos - slot.pos);
+            return true;
+        }
+    }
+    else
+    {
+        slot.text.assign(data, len);
+    }
+    slot.pos = pos;
+    return false;
+}
+
+void DataStream::forget_strings()
+{
+    for (size_t i = 0; i < m_strings.size(); i++)
+    {
+        m_strings[i].pos = -1;
+    }
+}
+
+
+void DataStream::write_varint(uint64_t value)
+{
+    if (m_view != NULL || m_size + 10 > (int64_t)m_buf.size())
+    {
+        reserve(10);
+    }
+    m_size += encode_varint(m_buf.data() + m_size, value);
+}
+
+void DataStream::write_varint(char type, uint64_t value)
+{
+    if (m_view != NULL || m_size + 11 > (int64_t)m_buf.size())
+    {
+        reserve(11);
+    }
+    char * buf = m_buf.data() + m_size;
+    buf[0] = type;
+    m_size += 1 + encode_varint(buf + 1, value);
+}
+
+void DataStream::write_compact(char type, int64_t value)
+{
+    write_varint(type, zigzag(value));
+}
+
+bool DataStream::read_compact(char type, int64_t & value)
+{
+    uint64_t raw;
+    if (!read_varint(type, raw))
+    {
+        return false;
+    }
+    value = unzigzag(raw);
+    return true;
+}
+
+bool DataStream::read_varint(char type, uint64_t & value)
+{
+    if (!peek(type))
+    {
+        return false;
+    }
+    ++m_pos;
+    if (!read_varint(value))
+    {
+        --m_pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::read_varint(uint64_t & value)
+{
+    const unsigned char * buf = (const unsigned char *)data() + m_pos;
+    int64_t avail = size() - m_pos;
+    uint64_t result = 0;
+    if (avail >= 10)
+    {
+        // enough bytes for the longest varint, so no per-byte bounds check
+        for (int i = 0; i < 10; i++)
+        {
+            result |= (uint64_t)(buf[i] & 0x7f) << (7 * i);
+            if (buf[i] < 0x80)
+            {
+                value = result;
+                m_pos += i + 1;
+                return true;
+            }
+        }
+        m_partial = false;
+        return false;
+    }
+    for (int i = 0; i < avail; i++)
+    {
+        result |= (uint64_t)(buf[i] & 0x7f) << (7 * i);
+        if (buf[i] < 0x80)
+        {
+            value = result;
+            m_pos += i + 1;
+            return true;
+        }
+    }
+    m_partial = true;
+    return false;
+}
+
+// a tagged length is an INT32 unless it needs the INT64
+void DataStream::write_length(int64_t len)
+{
+    if (m_compact)
+    {
+        write_varint(len);
+        return;
+    }
+    if (len > INT32_MAX)
+    {
+        write_tagged(DataType::INT64, len);
+        return;
+    }
+    write_tagged(DataType::INT32, (int32_t)len);
+}
+
+// the length prefix of an open container has a fixed width so it can be
+// patched later, compact mode pads the varint to five bytes
+// every element of a string or container takes at least one byte, so a
+// length larger than the bytes left is rejected before anything is allocated
+bool DataStream::read_length(int64_t & len)
+{
+    int64_t value;
+    if (m_compact)
+    {
+        uint64_t raw;
+        if (!read_varint(raw))
+        {
+            return false;
+        }
+        value = raw > (uint64_t)INT64_MAX ? -1 : (int64_t)raw;
+    }
+    else
+    {
+        int32_t raw;
+        if (read_tagged(DataType::INT32, raw))
+        {
+            value = raw;
+        }
+        else if (m_partial || !read_tagged(DataType::INT64, value))
+        {
+            return false;
+        }
+    }
+    if (value < 0)
+    {
+        m_partial = false;
+        return false;
+    }
+    // an incremental decoder has not necessarily received the elements yet
+    if (value > size() - m_pos && !m_incremental)
+    {
+        m_partial = true;
+        return false;
+    }
+    len = value;
+    return true;
+}
+
+bool DataStream::read(char * data, int64_t len)
+{
+    if (len < 0 || size() - m_pos < len)
+    {
+        m_partial = len >= 0;
+        return false;
+    }
+    if (len == 0)
+    {
+        return true;
     }
+    std::memcpy(data, this->data() + m_pos, len);
+    m_pos += len;
+    return true;
+}
+
+// the caller has checked that len bytes are there
+void DataStream::read_array(char * data, int64_t len, int width)
+{
+    if (!swapped())
+    {
+        read(data, len);
+        return;
+    }
+    swap_bytes(data, this->data() + m_pos, len, width);
+    m_pos += len;
+}
+
+bool DataStream::read(string & value)
+{
+    if (m_pos < size() && data()[m_pos] == DataType::STRINGREF)
+    {
+        StringView view;
+        if (!read_ref(view))
+        {
+            return false;
+        }
+        value.assign(view.data(), view.size());
+        return true;
+    }
+    if (!peek(DataType::STRING))
+    {
+        return false;
+    }
+    int64_t pos = m_pos++;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if (size() - m_pos < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    value.assign(data() + m_pos, len);
+    m_pos += len;
+    return true;
+}
+
+bool DataStream::read(StringView & value)
+{
+    if (m_pos < size() && data()[m_pos] == DataType::STRINGREF)
+    {
+        return read_ref(value);
+    }
+    if (!peek(DataType::STRING))
+    {
+        return false;
+    }
+    int64_t pos = m_pos++;
+    if (!read_field(value))
+    {
+        m_pos = pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::read(Serializable & value)
+{
+    return value.unserialize(*this);
+}
+
+// the value is a view of the earlier copy, so every reference to a string
+// shares the bytes of that one copy; the header of the copy is parsed in
+// place rather than by seeking back to it
+bool DataStream::read_ref(StringView & value)
+{
+    const char * buf = data();
+    const unsigned char * ref = (const unsigned char *)buf + m_pos + 1;
+    int64_t pos = m_pos;
+    uint64_t distance;
+    // most references are within 16KB, two varint bytes
+    if (size() - pos >= 3 && ref[0] < 0x80)
+    {
+        distance = ref[0];
+        m_pos += 2;
+    }
+    else if (size() - pos >= 3 && ref[1] < 0x80)
+    {
+        distance = (ref[0] & 0x7f) | (uint64_t)ref[1] << 7;
+        m_pos += 3;
+    }
+    else
+    {
+        ++m_pos;
+        if (!read_varint(distance))
+        {
+            m_pos = pos;
+            return false;
+        }
+    }
+    int64_t len = -1;
+    int64_t start = 0;
+    if (distance > 0 && distance <= (uint64_t)pos && buf[pos - distance] == DataType::STRING)
+    {
+        start = pos - distance + 1;
+        if (m_compact)
+        {
+            uint64_t raw = 0;
+            for (int i = 0; i < 5 && start < pos; i++)
+            {
+                raw |= (uint64_t)(buf[start] & 0x7f) << (7 * i);
+                if ((unsigned char)buf[start++] < 0x80)
+                {
+                    len = raw;
+                    break;
+                }
+            }
+        }
+        else if (pos - start >= 5 && buf[start] == DataType::INT32)
+        {
+            int32_t raw;
+            std::memcpy(&raw, buf + start + 1, sizeof(raw));
+            len = swapped() ? byteswap(raw) : raw;
+            start += 5;
+        }
+    }
+    if (len < 0 || len > pos - start)
+    {
+        m_partial = false;
+        m_pos = pos;
+        return false;
+    }
+    value = StringView(buf + start, len);
+    return true;
+}
+
+
+void DataStream::write_field(const string & value)
+{
+    int64_t len = value.size();
+    write_length(len);
+    write_payload(value.data(), len);
+}
+
+void DataStream::write_field(const StringView & value)
+{
+    int64_t len = value.size();
+    write_length(len);
+    write_payload(value.data(), len);
+}
+
+void DataStream::write_field(const Serializable & value)
+{
+    value.serialize(*this);
+}
+
+bool DataStream::read_field(string & value)
+{
+    StringView view;
+    if (!read_field(view))
+    {
+        return false;
+    }
+    value.assign(view.data(), view.size());
+    return true;
+}
+
+bool DataStream::read_field(StringView & value)
+{
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if (size() - m_pos < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    value = StringView(data() + m_pos, len);
+    m_pos += len;
+    return true;
+}
+
+bool DataStream::read_field(Serializable & value)
+{
+    return value.unserialize(*this);
+}
+
+void DataStream::set_compact(bool compact)
+{
+    m_compact = compact;
+}
+
+bool DataStream::compact() const
+{
+    return m_compact;
+}
+
+void DataStream::set_interned(bool interned)
+{
+    m_interned = interned;
+}
+
+bool DataStream::interned() const
+{
+    return m_interned;
+}
+
+void DataStream::set_indexed(bool indexed)
+{
+    m_indexed = indexed;
+}
+
+bool DataStream::indexed() const
+{
+    return m_indexed;
+}
+
+void DataStream::set_threads(int threads, int grain)
+{
+    if (threads <= 0)
+    {
+        threads = std::thread::hardware_concurrency();
+    }
+    m_threads = std::max(threads, 1);
+    m_grain = std::max(grain, 1);
+}
+
+int DataStream::threads() const
+{
+    return m_threads;
+}
+
+// the entry count of the indexed container of kind that starts here when it
+// is whole and large enough to decode in parallel, -1 to read it serially
+int64_t DataStream::parallel_count(char kind)
+{
+    if (m_threads <= 1 || m_incremental || m_pos >= size() || data()[m_pos] != DataType::INDEX)
+    {
+        return -1;
+    }
+    int64_t pos = m_pos;
+    int64_t len;
+    int64_t count;
+    int64_t table;
+    bool whole = read_index(kind, len, count, table) && size() - m_pos >= len;
+    m_pos = pos;
+    // chunks are bounded by 32-bit offsets
+    if (!whole || count < 2 * m_grain || len >= UINT32_MAX)
+    {
+        return -1;
+    }
+    return count;
+}
+
+// splits the entries of the indexed container that starts here into chunks
+// at offsets from its table; task(part, first, last) decodes entries first
+// to last - 1 from a stream over exactly their bytes, and must use them all
+bool DataStream::read_chunks(char kind, const std::function<bool(DataStream &, int64_t, int64_t)> & task)
+{
+    int64_t pos = m_pos;
+    int64_t len;
+    int64_t count;
+    int64_t table;
+    if (!read_index(kind, len, count, table))
+    {
+        return false;
+    }
+    int chunks = std::min<int64_t>(count / m_grain, m_threads * 4);
+    std::vector<int64_t> first(chunks + 1);
+    std::vector<uint32_t> bounds(chunks + 1);
+    for (int c = 0; c < chunks; c++)
+    {
+        first[c] = count * c / chunks;
+        load_field(data() + table + first[c] * 4, bounds[c]);
+    }
+    first[chunks] = count;
+    bounds[chunks] = len;
+    bool ok = bounds[0] == 0;
+    for (int c = 0; c < chunks; c++)
+    {
+        ok = ok && bounds[c] <= bounds[c + 1];
+    }
+    std::vector<char> done(chunks, 0);
+    const char * entries = data() + m_pos;
+    if (ok)
+    {
+        parallel_for(chunks, m_threads, [&](int c)
+        {
+            // the part also sees the bytes in front of its slice, which
+            // string references may point back into
+            int64_t back = std::min<int64_t>(m_pos + bounds[c], kInternWindow);
+            DataStream part;
+            part.attach(entries + bounds[c] - back, back + bounds[c + 1] - bounds[c]);
+            part.m_pos = back;
+            part.m_byteorder = m_byteorder;
+            part.m_compact = m_compact;
+            done[c] = task(part, first[c], first[c + 1]) && part.m_pos == part.size();
+        });
+        ok = std::find(done.begin(), done.end(), 0) == done.end();
+    }
+    if (!ok)
+    {
+        m_partial = false;
+        m_pos = pos;
+        return false;
+    }
+    m_pos += len;
+    return true;
+}
+
+void DataStream::set_byteorder(ByteOrder order)
+{
+    m_byteorder = order;
+}
+
+DataStream::ByteOrder DataStream::byteorder() const
+{
+    return m_byteorder;
+}
+
+void DataStream::attach(const char * data, int64_t len)
+{
+    m_size = 0;
+    m_mapping.reset();
+    m_view = data;
+    m_viewlen = len;
+    m_pos = 0;
+    m_frames.clear();
+    m_depth = 0;
+    forget_strings();
+}
+
+void DataStream::set_sink(Sink * sink, int chunk)
+{
+    clear();
+    m_sink = sink;
+    m_flushed = 0;
+    m_hold = -1;
+    m_open = 0;
+    m_sink_ok = true;
+    m_unsized = sink != NULL && !sink->seekable();
+    if ((int)m_buf.size() < chunk)
+    {
+        m_buf.resize(chunk);
+    }
+}
+
+bool DataStream::flush()
+{
+    if (m_sink == NULL)
+    {
+        return true;
+    }
+    // a non-seekable sink cannot be patched, so everything from the oldest
+    // open container onwards stays in the buffer until it is closed
+    int64_t len = m_size;
+    if (m_hold >= 0)
+    {
+        len = m_hold - m_flushed;
+    }
+    if (len > 0)
+    {
+        write_sink(m_buf.data(), len);
+        std::memmove(m_buf.data(), m_buf.data() + len, m_size - len);
+        m_size -= len;
+    }
+    return m_sink_ok;
+}
+
+void DataStream::set_gather(int64_t threshold)
+{
+    m_gather = threshold;
+}
+
+int64_t DataStream::gather() const
+{
+    return m_gather;
+}
+
+int64_t DataStream::iovecs(std::vector<struct iovec> & out) const
+{
+    out.clear();
+    out.reserve(2 * m_segments.size() + 1);
+    int64_t from = 0;
+    for (size_t i = 0; i < m_segments.size(); i++)
+    {
+        const Segment & seg = m_segments[i];
+        if (seg.pos > from)
+        {
+            out.push_back(iovec{ (void *)(data() + from), (size_t)(seg.pos - from) });
+        }
+        out.push_back(iovec{ (void *)seg.data, (size_t)seg.len });
+        from = seg.pos;
+    }
+    if (size() > from)
+    {
+        out.push_back(iovec{ (void *)(data() + from), (size_t)(size() - from) });
+    }
+    return size() + m_borrowed;
+}
+
+// sends everything iovecs lists, in batches of at most IOV_MAX segments and
+// picking up after short writes; with nothing borrowed it is the buffer alone
+bool DataStream::writev(int fd) const
+{
+    struct iovec one = { (void *)data(), (size_t)size() };
+    struct iovec * vec = &one;
+    size_t count = size() > 0 ? 1 : 0;
+    std::vector<struct iovec> segments;
+    if (!m_segments.empty())
+    {
+        iovecs(segments);
+        vec = segments.data();
+        count = segments.size();
+    }
+    size_t i = 0;
+    while (i < count)
+    {
+        int n = std::min<size_t>(count - i, IOV_MAX);
+        ssize_t done = ::writev(fd, vec + i, n);
+        if (done < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        while (i < count && done >= (ssize_t)vec[i].iov_len)
+        {
+            done -= vec[i].iov_len;
+            i++;
+        }
+        if (done > 0)
+        {
+            vec[i].iov_base = (char *)vec[i].iov_base + done;
+            vec[i].iov_len -= done;
+        }
+    }
+    return true;
+}
+
+// a sink takes an int length, so larger blocks go out a gigabyte at a time
+void DataStream::write_sink(const char * data, int64_t len)
+{
+    while (len > 0)
+    {
+        int n = std::min<int64_t>(len, 1 << 30);
+        m_sink_ok = m_sink->write(data, n) && m_sink_ok;
+        m_flushed += n;
+        data += n;
+        len -= n;
+    }
+}
+
+int64_t DataStream::begin_container(char type)
+{
+    write(&type, sizeof(char));
+    char buf[8];
+    int len = encode_length(buf, 0);
+    int64_t mark = m_flushed + m_size;
+    if (m_sink != NULL && m_hold < 0 && !m_sink->seekable())
+    {
+        m_hold = mark;
+    }
+    m_open++;
+    write(buf, len);
+    return mark;
+}
+
+bool DataStream::end_container(int64_t mark, int64_t len)
+{
+    char buf[8];
+    int n = encode_length(buf, len);
+    bool ok = true;
+    if (n == 0)
+    {
+        ok = widen_length(mark, len);
+    }
+    else if (mark >= m_flushed)
+    {
+        std::memcpy(&m_buf[mark - m_flushed], buf, n);
+    }
+    else
+    {
+        ok = m_sink->patch(mark, buf, n);
+    }
+    if (--m_open == 0)
+    {
+        m_hold = -1;
+    }
+    return ok;
+}
+
+// a length too large for its five byte prefix gets a longer one, an INT64 or
+// an unpadded varint, by moving everything after the prefix up; that needs the
+// prefix still buffered, and no string reference that might reach across it,
+// otherwise the prefix is left holding a length every reader rejects
+bool DataStream::widen_length(int64_t mark, int64_t len)
+{
+    if (mark < m_flushed || m_interned)
+    {
+        if (mark >= m_flushed && !m_compact)
+        {
+            encode_length(&m_buf[mark - m_flushed], -1);
+        }
+        return false;
+    }
+    char buf[16];
+    int n;
+    if (m_compact)
+    {
+        n = encode_varint(buf, len);
+    }
+    else
+    {
+        buf[0] = DataType::INT64;
+        int64_t value = swapped() ? byteswap(len) : len;
+        std::memcpy(buf + 1, &value, sizeof(value));
+        n = 1 + sizeof(value);
+    }
+    int64_t at = mark - m_flushed;
+    if (m_size + n - 5 > (int64_t)m_buf.size())
+    {
+        m_buf.resize(std::max<int64_t>(m_size + n - 5, m_buf.size() * 2));
+    }
+    std::memmove(&m_buf[at + n], &m_buf[at + 5], m_size - at - 5);
+    std::memcpy(&m_buf[at], buf, n);
+    m_size += n - 5;
+    for (size_t i = 0; i < m_segments.size(); i++)
+    {
+        if (m_segments[i].pos > at)
+        {
+            m_segments[i].pos += n - 5;
+        }
+    }
+    return true;
+}
+
+static const uint32_t kRecordChecksum = 0x80000000;
+
+// record headers are little endian whatever the stream's byte order, so
+// the frames can be found without knowing how their payloads are encoded
+static inline void store_le32(char * buf, uint32_t value)
+{
+    if (kHostBigEndian)
+    {
+        value = byteswap(value);
+    }
+    std::memcpy(buf, &value, sizeof(value));
+}
+
+static inline uint32_t load_le32(const char * buf)
+{
+    uint32_t value;
+    std::memcpy(&value, buf, sizeof(value));
+    return kHostBigEndian ? byteswap(value) : value;
+}
+
+int64_t DataStream::begin_record(bool checksum)
+{
+    reserve(8);
+    int64_t mark = m_flushed + m_size;
+    // a record is decoded on its own, so its strings cannot refer to
+    // anything written before it
+    forget_strings();
+    // the record stays buffered until end_record has filled in its header
+    if (m_sink != NULL && m_hold < 0)
+    {
+        m_hold = mark;
+    }
+    m_open++;
+    char header[8] = { 0 };
+    store_le32(header, checksum ? kRecordChecksum : 0);
+    write(header, checksum ? 8 : 4);
+    return mark;
+}
+
+void DataStream::end_record(int64_t mark)
+{
+    char * head = &m_buf[mark - m_flushed];
+    uint32_t word = load_le32(head);
+    int header = (word & kRecordChecksum) ? 8 : 4;
+    int64_t borrowed = borrowed_since(mark);
+    int64_t len = m_flushed + m_size - mark - header + borrowed;
+    // the length has 31 bits, which also keeps every checksummed piece
+    // within what crc32c takes
+    if (len > (int64_t)~kRecordChecksum)
+    {
+        // the record is dropped whole, so the stream can go on after the
+        // exception is caught
+        int64_t at = mark - m_flushed;
+        auto it = std::upper_bound(m_segments.begin(), m_segments.end(), at, [](int64_t at, const Segment & seg)
+        {
+            return at < seg.pos;
+        });
+        if (it != m_segments.end())
+        {
+            m_borrowed = it->before;
+            m_segments.erase(it, m_segments.end());
+        }
+        m_size = at;
+        forget_strings();
+        if (--m_open == 0)
+        {
+            m_hold = -1;
+        }
+        throw std::length_error("record too large");
+    }
+    word = (word & kRecordChecksum) | len;
+    store_le32(head, word);
+    if ((word & kRecordChecksum) && borrowed == 0)
+    {
+        store_le32(head + 4, crc32c(head + header, len));
+    }
+    else if (word & kRecordChecksum)
+    {
+        // borrowed payloads are checksummed where they live
+        int64_t from = mark - m_flushed + header;
+        uint32_t crc = 0;
+        for (size_t i = 0; i < m_segments.size(); i++)
+        {
+            const Segment & seg = m_segments[i];
+            if (seg.pos >= from)
+            {
+                crc = crc32c(&m_buf[from], seg.pos - from, crc);
+                crc = crc32c(seg.data, seg.len, crc);
+                from = seg.pos;
+            }
+        }
+        crc = crc32c(&m_buf[from], m_size - from, crc);
+        store_le32(head + 4, crc);
+    }
+    if (--m_open == 0)
+    {
+        m_hold = -1;
+    }
+}
+
+bool DataStream::read_record(StringView & payload)
+{
+    int64_t pos = m_pos;
+    if (!skip_record())
+    {
+        return false;
+    }
+    uint32_t word = load_le32(data() + pos);
+    int header = (word & kRecordChecksum) ? 8 : 4;
+    payload = StringView(data() + pos + header, m_pos - pos - header);
+    if (word & kRecordChecksum)
+    {
+        uint32_t crc = load_le32(data() + pos + 4);
+        if (crc32c(payload.data(), payload.size()) != crc)
+        {
+            m_partial = false;
+            m_pos = pos;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DataStream::skip_record()
+{
+    int64_t pos = m_pos;
+    if (size() - m_pos < 4)
+    {
+        m_partial = true;
+        return false;
+    }
+    uint32_t word = load_le32(data() + m_pos);
+    m_pos += 4;
+    int64_t len = word & ~kRecordChecksum;
+    if (word & kRecordChecksum)
+    {
+        len += 4;
+    }
+    if (size() - m_pos < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    m_pos += len;
+    return true;
+}
+
+// len is the byte length of the fields, or -1 for an unsized CUSTOM object
+bool DataStream::read_sized_header(int64_t & len)
+{
+    if (m_pos < size() && data()[m_pos] == DataType::CUSTOM)
+    {
+        ++m_pos;
+        len = -1;
+        return true;
+    }
+    if (m_pos < size() && data()[m_pos] == DataType::INDEX)
+    {
+        int64_t count;
+        int64_t table;
+        return read_index(DataType::CUSTOM, len, count, table);
+    }
+    if (!peek(DataType::OBJECT))
+    {
+        return false;
+    }
+    int64_t pos = m_pos++;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::open_object()
+{
+    int64_t len;
+    return read_header(len);
+}
+
+// a table of count uint32 offsets in the stream's byte order, relative to
+// the first entry, sits between the header and the entries
+DataStream::Index DataStream::begin_index(char kind, int64_t count)
+{
+    char header[2] = { DataType::INDEX, kind };
+    write(header, sizeof(header));
+    Index index;
+    index.mark = m_flushed + m_size;
+    index.count = count;
+    // the table is filled in entry by entry, so it stays buffered until the end
+    if (m_sink != NULL && m_hold < 0)
+    {
+        m_hold = index.mark;
+    }
+    m_open++;
+    char buf[8];
+    write(buf, encode_length(buf, 0));
+    write_length(count);
+    reserve(count * 4);
+    std::memset(m_buf.data() + m_size, 0, count * 4);
+    index.table = m_flushed + m_size;
+    m_size += count * 4;
+    return index;
+}
+
+// ahead is how far past the current end the entry starts; an entry past
+// what a 32-bit offset reaches gets UINT32_MAX and is found by scanning
+void DataStream::index_entry(const Index & index, int64_t i, int64_t ahead)
+{
+    int64_t entries = index.table + index.count * 4;
+    int64_t offset = m_flushed + m_size + ahead - entries + borrowed_since(entries);
+    uint32_t value = std::min<int64_t>(offset, UINT32_MAX);
+    store_fields(&m_buf[index.table + i * 4 - m_flushed], value);
+}
+
+void DataStream::end_index(const Index & index)
+{
+    char * buf = &m_buf[index.mark - m_flushed];
+    int64_t len = m_flushed + m_size - index.mark - 5 + borrowed_since(index.mark);
+    if (encode_length(buf, len) == 0)
+    {
+        widen_length(index.mark, len);
+    }
+    if (--m_open == 0)
+    {
+        m_hold = -1;
+    }
+}
+
+// consumes an INDEX header and its offset table; len is the byte length of
+// the entries and table the position of the offsets
+bool DataStream::read_index(char kind, int64_t & len, int64_t & count, int64_t & table)
+{
+    if (size() - m_pos < 2 || data()[m_pos] != DataType::INDEX || data()[m_pos + 1] != kind)
+    {
+        m_partial = size() - m_pos < 2 && (m_pos >= size() || data()[m_pos] == DataType::INDEX);
+        return false;
+    }
+    int64_t pos = m_pos;
+    m_pos += 2;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    int64_t start = m_pos;
+    if (!read_length(count))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if ((size() - m_pos) / 4 < count)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    table = m_pos;
+    m_pos += count * 4;
+    len -= m_pos - start;
+    if (len < 0)
+    {
+        m_partial = false;
+        m_pos = pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::seek_field(int index)
+{
+    return seek_entry(DataType::CUSTOM, index);
+}
+
+bool DataStream::seek_element(int64_t index)
+{
+    return seek_entry(DataType::VECTOR, index);
+}
+
+bool DataStream::seek_entry(char kind, int64_t index)
+{
+    int64_t pos = m_pos;
+    int64_t len;
+    int64_t count;
+    if (m_pos < size() && data()[m_pos] == DataType::INDEX)
+    {
+        int64_t table;
+        if (!read_index(kind, len, count, table))
+        {
+            return false;
+        }
+        uint32_t offset = 0;
+        int64_t first = index;
+        if (index >= 0 && index < count)
+        {
+            load_field(data() + table + index * 4, offset);
+        }
+        if (offset == UINT32_MAX)
+        {
+            // past what the table reaches, step over the entries from the
+            // last one it does
+            int64_t lo = 0;
+            int64_t hi = index;
+            while (hi - lo > 1)
+            {
+                int64_t mid = lo + (hi - lo) / 2;
+                load_field(data() + table + mid * 4, offset);
+                if (offset == UINT32_MAX)
+                {
+                    hi = mid;
+                }
+                else
+                {
+                    lo = mid;
+                }
+            }
+            first = lo;
+            load_field(data() + table + lo * 4, offset);
+        }
+        if (index < 0 || index >= count || offset > len)
+        {
+            m_partial = false;
+            m_pos = pos;
+            return false;
+        }
+        if (size() - m_pos < offset)
+        {
+            m_partial = true;
+            m_pos = pos;
+            return false;
+        }
+        m_pos += offset;
+        for (int64_t i = first; i < index; i++)
+        {
+            if (!skip())
+            {
+                m_pos = pos;
+                return false;
+            }
+        }
+        return true;
+    }
+    // no offset table, so step over the entries before index
+    int64_t end = size();
+    count = INT64_MAX;
+    if (kind == DataType::CUSTOM)
+    {
+        if (!read_header(len))
+        {
+            return false;
+        }
+        if (len >= 0)
+        {
+            end = m_pos + len;
+        }
+    }
+    else
+    {
+        if (!peek(kind))
+        {
+            return false;
+        }
+        ++m_pos;
+        if (!read_length(count))
+        {
+            m_pos = pos;
+            return false;
+        }
+    }
+    for (int64_t i = 0; i < index && i < count && m_pos < end; i++)
+    {
+        if (!skip())
+        {
+            m_pos = pos;
+            return false;
+        }
+    }
+    if (index < 0 || index >= count || m_pos >= end)
+    {
+        m_partial = m_pos >= size() && end > size();
+        m_pos = pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::skip()
+{
+    int64_t pos = m_pos;
+    if (!skip_value())
+    {
+        m_pos = pos;
+        return false;
+    }
+    return true;
+}
+
+bool DataStream::skip_bytes(int64_t len)
+{
+    if (size() - m_pos < len)
+    {
+        m_partial = true;
+        return false;
+    }
+    m_pos += len;
+    return true;
 }
 
-DataStream::ByteOrder DataStream::byteorder()
+bool DataStream::skip_value()
 {
-    int n = 0x12345678;
-    char str[4];
-    memcpy(str, &n, sizeof(int));
-    if (str[0] == 0x12)
+    if (m_pos >= size())
     {
-        return ByteOrder::BigEndian;
+        m_partial = true;
+        return false;
     }
-    else
+    int64_t len = 0;
+    switch ((DataType)data()[m_pos])
     {
-        return ByteOrder::LittleEndian;
+    case DataType::BOOL:
+    case DataType::CHAR:
+    case DataType::INT8:
+    case DataType::UINT8:
+        return skip_bytes(2);
+    case DataType::INT16:
+    case DataType::UINT16:
+    case DataType::INT32:
+    case DataType::UINT32:
+    case DataType::INT64:
+    case DataType::UINT64:
+    {
+        if (m_compact)
+        {
+            uint64_t value;
+            ++m_pos;
+            return read_varint(value);
+        }
+        char type = data()[m_pos];
+        if (type == DataType::INT16 || type == DataType::UINT16)
+        {
+            return skip_bytes(3);
+        }
+        return skip_bytes(type == DataType::INT32 || type == DataType::UINT32 ? 5 : 9);
     }
-}
-
-void DataStream::show() const
-{
-    int size = m_buf.size();
-    std::cout << "data size = " << size << std::endl;
-    int i = 0;
-    while (i < size)
+    case DataType::STRINGREF:
     {
-        switch ((DataType)m_buf[i])
+        uint64_t value;
+        ++m_pos;
+        return read_varint(value);
+    }
+    case DataType::FLOAT:
+        return skip_bytes(5);
+    case DataType::DOUBLE:
+        return skip_bytes(9);
+    case DataType::STRING:
+    case DataType::OBJECT:
+        ++m_pos;
+        return read_length(len) && skip_bytes(len);
+    case DataType::INDEX:
+        if (size() - m_pos < 2)
         {
-        case DataType::BOOL:
-            if ((int)m_buf[++i] == 0)
-            {
-                std::cout << "false";
-            }
-            else
+            m_partial = true;
+            return false;
+        }
+        m_pos += 2;
+        return read_length(len) && skip_bytes(len);
+    case DataType::VECTOR:
+    case DataType::LIST:
+    case DataType::SET:
+    case DataType::MAP:
+    {
+        int count = data()[m_pos] == DataType::MAP ? 2 : 1;
+        ++m_pos;
+        if (!read_length(len))
+        {
+            return false;
+        }
+        for (int64_t i = 0; i < (int64_t)len * count; i++)
+        {
+            if (!skip_value())
             {
-                std::cout << "true";
+                return false;
             }
-            ++i;
-            break;
+        }
+        return true;
+    }
+    case DataType::ARRAY:
+    {
+        if (size() - m_pos < 2)
+        {
+            m_partial = true;
+            return false;
+        }
+        int width;
+        switch ((DataType)data()[m_pos + 1])
+        {
         case DataType::CHAR:
-            std::cout << m_buf[++i];
-            ++i;
+        case DataType::INT8:
+        case DataType::UINT8:
+            width = 1;
             break;
-        case DataType::INT32:
-            std::cout << *((int32_t *)(&m_buf[++i]));
-            i += 4;
-            break;
-        case DataType::INT64:
-            std::cout << *((int64_t *)(&m_buf[++i]));
-            i += 8;
+        case DataType::INT16:
+        case DataType::UINT16:
+            width = 2;
             break;
+        case DataType::INT32:
+        case DataType::UINT32:
         case DataType::FLOAT:
-            std::cout << *((float *)(&m_buf[++i]));
-            i += 4;
+            width = 4;
             break;
+        case DataType::INT64:
+        case DataType::UINT64:
         case DataType::DOUBLE:
-            std::cout << *((double *)(&m_buf[++i]));
-            i += 8;
-            break;
-        case DataType::STRING:
-            if ((DataType)m_buf[++i] == DataType::INT32)
-            {
-                int len = *((int *)(&m_buf[++i]));
-                i += 4;
-                std::cout << string(&m_buf[i], len);
-                i += len;
-            }
-            else
-            {
-                throw std::logic_error("parse string error");
-            }
-            break;
-        case DataType::VECTOR:
-            if ((DataType)m_buf[++i] == DataType::INT32)
-            {
-                int len = *((int *)(&m_buf[++i]));
-                i += 4;
-            }
-            else
-            {
-                throw std::logic_error("parse vector error");
-            }
-            break;
-        case DataType::MAP:
-            if ((DataType)m_buf[++i] == DataType::INT32)
-            {
-                int len = *((int *)(&m_buf[++i]));
-                i += 4;
-            }
-            else
-            {
-                throw std::logic_error("parse map error");
-            }
-            break;
-        case DataType::SET:
-            if ((DataType)m_buf[++i] == DataType::INT32)
-            {
-                int len = *((int *)(&m_buf[++i]));
-                i += 4;
-            }
-            else
-            {
-                throw std::logic_error("parse set error");
-            }
-            break;
-        case DataType::CUSTOM:
+            width = 8;
             break;
         default:
-            break;
+            m_partial = false;
+            return false;
+        }
+        m_pos += 2;
+        if (!read_length(len))
+        {
+            return false;
+        }
+        if ((size() - m_pos) / width < len)
+        {
+            m_partial = true;
+            return false;
         }
+        m_pos += len * width;
+        return true;
+    }
+    default:
+        // an unsized CUSTOM object does not say where it ends
+        m_partial = false;
+        return false;
     }
-    std::cout << std::endl;
-}
-
-void DataStream::write(const char * data, int len)
-{
-    reserve(len);
-    int size = m_buf.size();
-    m_buf.resize(m_buf.size() + len);
-    std::memcpy(&m_buf[size], data, len);
 }
 
-void DataStream::write(bool value)
+void DataStream::set_incremental(bool incremental)
 {
-    char type = DataType::BOOL;
-    write((char *)&type, sizeof(char));
-    write((char *)&value, sizeof(char));
+    m_incremental = incremental;
+    m_frames.clear();
+    m_depth = 0;
 }
 
-void DataStream::write(char value)
+bool DataStream::partial() const
 {
-    char type = DataType::CHAR;
-    write((char *)&type, sizeof(char));
-    write((char *)&value, sizeof(char));
+    return m_partial;
 }
 
-void DataStream::write(int32_t value)
+// appends received bytes, dropping the consumed prefix once it is at least
+// half the buffer so a long-lived connection buffer does not keep growing;
+// an interned stream keeps the window that string references reach into
+void DataStream::feed(const char * data, int64_t len)
 {
-    char type = DataType::INT32;
-    write((char *)&type, sizeof(char));
-    if (m_byteorder == ByteOrder::BigEndian)
+    int64_t drop = m_interned ? m_pos - std::min<int64_t>(m_pos, kInternWindow) : m_pos;
+    if (m_view == NULL && drop > 0 && m_pos >= m_size / 2)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(int32_t);
-        std::reverse(first, last);
+        std::memmove(m_buf.data(), m_buf.data() + drop, m_size - drop);
+        m_size -= drop;
+        m_pos -= drop;
     }
-    write((char *)&value, sizeof(int32_t));
+    write(data, len);
 }
 
-void DataStream::write(int64_t value)
+// enters a container or object, or the frame saved for it by a partial read
+// an object is entered with its field count in len, a container reads its
+// element count into len
+bool DataStream::enter(char type, int64_t & len, int64_t & done)
 {
-    char type = DataType::INT64;
-    write((char *)&type, sizeof(char));
-    if (m_byteorder == ByteOrder::BigEndian)
+    if (resuming())
+    {
+        const Frame & frame = m_frames[m_depth++];
+        len = frame.len;
+        done = frame.done;
+        return true;
+    }
+    if (type == DataType::CUSTOM)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(int64_t);
-        std::reverse(first, last);
+        int64_t body;
+        if (!read_header(body))
+        {
+            return false;
+        }
+    }
+    else if (m_pos < size() && data()[m_pos] == DataType::INDEX)
+    {
+        int64_t bytes;
+        int64_t table;
+        if (!read_index(type, bytes, len, table))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if (!peek(type))
+        {
+            return false;
+        }
+        int64_t pos = m_pos++;
+        if (!read_length(len))
+        {
+            m_pos = pos;
+            return false;
+        }
+    }
+    done = 0;
+    if (m_incremental)
+    {
+        m_frames.push_back(Frame{ len, 0 });
+        m_depth++;
     }
-    write((char *)&value, sizeof(int64_t));
+    return true;
 }
 
-void DataStream::write(float value)
+// leaves a container or object; after a short read its frame keeps the
+// number of finished elements so the next call continues from there
+bool DataStream::leave(bool ok, int64_t done)
 {
-    char type = DataType::FLOAT;
-    write((char *)&type, sizeof(char));
-    if (m_byteorder == ByteOrder::BigEndian)
+    if (!m_incremental)
+    {
+        return ok;
+    }
+    m_depth--;
+    if (ok)
+    {
+        m_frames.pop_back();
+    }
+    else if (m_partial)
+    {
+        m_frames[m_depth].done = done;
+    }
+    else if (m_depth == 0)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(float);
-        std::reverse(first, last);
+        m_frames.clear();
     }
-    write((char *)&value, sizeof(float));
+    return ok;
 }
 
-void DataStream::write(double value)
+// restarts the current element, discarding any partial state below it
+void DataStream::rewind(int64_t pos)
 {
-    char type = DataType::DOUBLE;
-    write((char *)&type, sizeof(char));
-    if (m_byteorder == ByteOrder::BigEndian)
+    m_pos = pos;
+    if (m_incremental)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(double);
-        std::reverse(first, last);
+        m_frames.resize(m_depth);
     }
-    write((char *)&value, sizeof(double));
 }
 
-void DataStream::write(const char * value)
+void DataStream::clear()
 {
-    char type = DataType::STRING;
-    write((char *)&type, sizeof(char));
-    int len = strlen(value);
-    write(len);
-    write(value, len);
+    m_frames.clear();
+    m_depth = 0;
+    m_size = 0;
+    m_segments.clear();
+    m_borrowed = 0;
+    m_view = NULL;
+    m_viewlen = 0;
+    m_mapping.reset();
+    m_pos = 0;
+    m_partial = false;
+    forget_strings();
 }
 
-void DataStream::write(const string & value)
+void DataStream::swap(Buffer & buf)
 {
-    char type = DataType::STRING;
-    write((char *)&type, sizeof(char));
-    int len = value.size();
-    write(len);
-    write(value.data(), len);
+    if (m_view != NULL)
+    {
+        reserve(0);
+    }
+    m_buf.resize(m_size);
+    m_buf.swap(buf);
+    m_size = m_buf.size();
+    m_pos = 0;
+    m_partial = false;
+    m_frames.clear();
+    m_depth = 0;
+    m_segments.clear();
+    m_borrowed = 0;
+    forget_strings();
 }
 
-void DataStream::write(const Serializable & value)
+Buffer DataStream::release()
 {
-    value.serialize(*this);
+    Buffer buf;
+    if (m_pool != NULL)
+    {
+        m_pool->acquire(buf);
+        buf.clear();
+    }
+    swap(buf);
+    return buf;
 }
 
-
-void DataStream::write_args()
+void DataStream::reset()
 {
+    m_frames.clear();
+    m_depth = 0;
+    m_pos = 0;
 }
 
-bool DataStream::read(char * data, int len)
+int64_t DataStream::tell() const
 {
-    std::memcpy(data, (char *)&m_buf[m_pos], len);
-    m_pos += len;
-    return true;
+    return m_pos;
 }
 
-bool DataStream::read(bool & value)
+bool DataStream::seek(int64_t pos)
 {
-    if (m_buf[m_pos] != DataType::BOOL)
+    if (pos < 0 || pos > size())
     {
         return false;
     }
-    ++m_pos;
-    value = m_buf[m_pos];
-    ++m_pos;
+    m_frames.clear();
+    m_depth = 0;
+    m_pos = pos;
     return true;
 }
 
-bool DataStream::read(char & value)
+void DataStream::save(const string & filename)
 {
-    if (m_buf[m_pos] != DataType::CHAR)
-    {
-        return false;
-    }
-    ++m_pos;
-    value = m_buf[m_pos];
-    ++m_pos;
-    return true;
+    save_file(filename, data(), size());
+}
+
+void DataStream::save(const string & filename, Codec codec, int block)
+{
+    Buffer packed;
+    compress(data(), size(), packed, codec, block, m_threads);
+    save_file(filename, packed.data(), packed.size());
 }
 
-bool DataStream::read(int32_t & value)
+void DataStream::save_file(const string & filename, const char * buf, size_t left)
 {
-    if (m_buf[m_pos] != DataType::INT32)
+    int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
     {
-        return false;
+        return;
     }
-    ++m_pos;
-    value = *((int32_t *)(&m_buf[m_pos]));
-    if (m_byteorder == ByteOrder::BigEndian)
+    while (left > 0)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(int32_t);
-        std::reverse(first, last);
+        ssize_t n = ::write(fd, buf, left);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        buf += n;
+        left -= n;
     }
-    m_pos += 4;
-    return true;
+    ::close(fd);
 }
 
-bool DataStream::read(int64_t & value)
+void DataStream::load(const string & filename)
 {
-    if (m_buf[m_pos] != DataType::INT64)
+    clear();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
     {
-        return false;
+        return;
     }
-    ++m_pos;
-    value = *((int64_t *)(&m_buf[m_pos]));
-    if (m_byteorder == ByteOrder::BigEndian)
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        if ((off_t)m_buf.size() < st.st_size)
+        {
+            m_buf.resize(st.st_size);
+        }
+        size_t total = 0;
+        while (total < (size_t)st.st_size)
+        {
+            ssize_t n = ::read(fd, &m_buf[total], st.st_size - total);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                break;
+            }
+            total += n;
+        }
+        m_size = total;
+    }
+    ::close(fd);
+    if (is_compressed(m_buf.data(), m_size))
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(int64_t);
-        std::reverse(first, last);
+        unpack(m_buf.data(), m_size);
     }
-    m_pos += 8;
-    return true;
 }
 
-bool DataStream::read(float & value)
+// replaces the contents with the decompressed container at data, which may
+// point into the stream's own buffer
+void DataStream::unpack(const char * data, int64_t len)
 {
-    if (m_buf[m_pos] != DataType::FLOAT)
-    {
-        return false;
-    }
-    ++m_pos;
-    value = *((float *)(&m_buf[m_pos]));
-    if (m_byteorder == ByteOrder::BigEndian)
+    Buffer raw;
+    bool ok = decompress(data, len, raw, m_threads);
+    clear();
+    if (ok)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(float);
-        std::reverse(first, last);
+        m_buf.swap(raw);
+        m_size = m_buf.size();
     }
-    m_pos += 4;
-    return true;
 }
 
-bool DataStream::read(double & value)
+void DataStream::map(const string & filename)
 {
-    if (m_buf[m_pos] != DataType::DOUBLE)
+    clear();
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
     {
-        return false;
+        return;
     }
-    ++m_pos;
-    value = *((double *)(&m_buf[m_pos]));
-    if (m_byteorder == ByteOrder::BigEndian)
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size == 0)
     {
-        char * first = (char *)&value;
-        char * last = first + sizeof(double);
-        std::reverse(first, last);
+        ::close(fd);
+        return;
     }
-    m_pos += 8;
-    return true;
-}
-
-bool DataStream::read(string & value)
-{
-    if (m_buf[m_pos] != DataType::STRING)
+    size_t len = st.st_size;
+    void * addr = ::mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED)
     {
-        return false;
+        return;
     }
-    ++m_pos;
-    int len;
-    read(len);
-    if (len < 0)
+    ::madvise(addr, len, MADV_SEQUENTIAL);
+    if (is_compressed((const char *)addr, len))
     {
-        return false;
+        unpack((const char *)addr, len);
+        ::munmap(addr, len);
+        return;
     }
-    value.assign((char *)&(m_buf[m_pos]), len);
-    m_pos += len;
-    return true;
-}
-
-bool DataStream::read(Serializable & value)
-{
-    return value.unserialize(*this);
-}
-
-
-bool DataStream::read_args()
-{
-    return true;
+    m_mapping = std::shared_ptr<void>(addr, [len](void * p) { ::munmap(p, len); });
+    m_view = (const char *)addr;
+    m_viewlen = len;
+    m_pos = 0;
 }
 
-const char * DataStream::data() const
+DataStream & DataStream::operator << (bool value)
 {
-    return m_buf.data();
+    write(value);
+    return *this;
 }
 
-int DataStream::size() const
+DataStream & DataStream::operator << (char value)
 {
-    return m_buf.size();
+    write(value);
+    return *this;
 }
 
-void DataStream::clear()
+DataStream & DataStream::operator << (int32_t value)
 {
-    m_buf.clear();
+    write(value);
+    return *this;
 }
 
-void DataStream::reset()
+DataStream & DataStream::operator << (int64_t value)
 {
-    m_pos = 0;
+    write(value);
+    return *this;
 }
 
-void DataStream::save(const string & filename)
+DataStream & DataStream::operator << (int8_t value)
 {
-    ofstream fout(filename);
-    fout.write(data(), size());
-    fout.flush();
-    fout.close();
+    write(value);
+    return *this;
 }
 
-void DataStream::load(const string & filename)
+DataStream & DataStream::operator << (uint8_t value)
 {
-    ifstream fin(filename);
-    stringstream ss;
-    ss << fin.rdbuf();
-    const string & str = ss.str();
-    m_buf.clear();
-    reserve(str.size());
-    write(str.data(), str.size());
+    write(value);
+    return *this;
 }
 
-DataStream & DataStream::operator << (bool value)
+DataStream & DataStream::operator << (int16_t value)
 {
     write(value);
     return *this;
 }
 
-DataStream & DataStream::operator << (char value)
+DataStream & DataStream::operator << (uint16_t value)
 {
     write(value);
     return *this;
 }
 
-DataStream & DataStream::operator << (int32_t value)
+DataStream & DataStream::operator << (uint32_t value)
 {
     write(value);
     return *this;
 }
 
-DataStream & DataStream::operator << (int64_t value)
+DataStream & DataStream::operator << (uint64_t value)
 {
     write(value);
     return *this;
@@ -470,6 +2047,12 @@ DataStream & DataStream::operator << (const string & value)
     return *this;
 }
 
+DataStream & DataStream::operator << (const StringView & value)
+{
+    write(value);
+    return *this;
+}
+
 DataStream & DataStream::operator << (const Serializable & value)
 {
     write(value);
@@ -500,6 +2083,42 @@ DataStream & DataStream::operator >> (int64_t & value)
     return *this;
 }
 
+DataStream & DataStream::operator >> (int8_t & value)
+{
+    read(value);
+    return *this;
+}
+
+DataStream & DataStream::operator >> (uint8_t & value)
+{
+    read(value);
+    return *this;
+}
+
+DataStream & DataStream::operator >> (int16_t & value)
+{
+    read(value);
+    return *this;
+}
+
+DataStream & DataStream::operator >> (uint16_t & value)
+{
+    read(value);
+    return *this;
+}
+
+DataStream & DataStream::operator >> (uint32_t & value)
+{
+    read(value);
+    return *this;
+}
+
+DataStream & DataStream::operator >> (uint64_t & value)
+{
+    read(value);
+    return *this;
+}
+
 DataStream & DataStream::operator >> (float & value)
 {
     read(value);
@@ -518,6 +2137,12 @@ DataStream & DataStream::operator >> (string & value)
     return *this; 
 }
 
+DataStream & DataStream::operator >> (StringView & value)
+{
+    read(value);
+    return *this;
+}
+
 DataStream & DataStream::operator >> (Serializable & value)
 {
     read(value);
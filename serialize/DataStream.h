@@ -3,21 +3,69 @@
 #include <iostream>
 #include <string>
 #include <cstring>
+#include <cstdint>
 #include <vector>
 #include <list>
+#include <deque>
+#include <array>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <tuple>
+#include <utility>
 #include <stdexcept>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#include <type_traits>
+#include <sys/uio.h>
 using namespace std;
 
+#include <serialize/Arena.h>
+#include <serialize/Buffer.h>
+#include <serialize/Checksum.h>
+#include <serialize/Compress.h>
+#include <serialize/Endian.h>
+#include <serialize/Parallel.h>
+#include <serialize/Reflect.h>
 #include <serialize/Serializable.h>
+#include <serialize/Sink.h>
+#include <serialize/View.h>
 
 namespace yazi {
 namespace serialize {
 
+// whether every type in a field list has a fixed width, and the total width
+template <typename ...Args>
+struct FixedFields
+{
+    static const bool value = true;
+    static const int size = 0;
+};
+
+template <typename T, typename ...Args>
+struct FixedFields<T, Args...>
+{
+    static const bool value = std::is_arithmetic<T>::value && FixedFields<Args...>::value;
+    static const int size = sizeof(T) + FixedFields<Args...>::size;
+};
+
+// 0 ... N - 1 as a parameter pack, for unpacking tuples
+template <size_t ...I>
+struct Indices {};
+
+template <size_t N, size_t ...I>
+struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+
+template <size_t ...I>
+struct MakeIndices<0, I...>
+{
+    typedef Indices<I...> type;
+};
+
 class DataStream
 {
 public:
@@ -34,7 +82,17 @@ public:
         LIST,
         MAP,
         SET,
-        CUSTOM
+        CUSTOM,
+        ARRAY,
+        OBJECT,
+        INDEX,
+        STRINGREF,
+        INT8,
+        UINT8,
+        INT16,
+        UINT16,
+        UINT32,
+        UINT64
     };
 
     enum ByteOrder
@@ -45,19 +103,39 @@ public:
 
     DataStream();
     DataStream(const string & data);
+    DataStream(BufferPool * pool);
+
+    // adopts buf's bytes without copying them, ready to be read from the start
+    DataStream(Buffer && buf);
     ~DataStream();
 
     void show() const;
-    void write(const char * data, int len);
+    void write(const char * data, int64_t len);
     void write(bool value);
     void write(char value);
     void write(int32_t value);
     void write(int64_t value);
+    void write(int8_t value);
+    void write(uint8_t value);
+    void write(int16_t value);
+    void write(uint16_t value);
+    void write(uint32_t value);
+    void write(uint64_t value);
     void write(float value);
     void write(double value);
     void write(const char * value);
     void write(const string & value);
+    void write(const StringView & value);
     void write(const Serializable & value);
+
+    template<typename T>
+    typename std::enable_if<Reflect<T>::value>::type write(const T & value);
+
+    template<typename Alloc>
+    void write(const std::basic_string<char, std::char_traits<char>, Alloc>& val);
+
+    template<typename T>
+    void write(const ArrayView<T>& val);
  
     template<typename T, typename Alloc = std::allocator<T>>
     void write(const std::vector<T, Alloc>& val);
@@ -71,21 +149,58 @@ public:
     template<typename K, typename Compare = std::less<K>, typename Alloc = std::allocator<K>>
     void write(const std::set<K, Compare, Alloc>& val);
 
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<std::pair<const K, V>>>
+    void write(const std::unordered_map<K, V, Hash, Equal, Alloc>& val);
+
+    template<typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<K>>
+    void write(const std::unordered_set<K, Hash, Equal, Alloc>& val);
+
+    template<typename T, typename Alloc = std::allocator<T>>
+    void write(const std::deque<T, Alloc>& val);
+
+    template<typename T, size_t N>
+    void write(const std::array<T, N>& val);
+
+    template<typename A, typename B>
+    void write(const std::pair<A, B>& val);
+
+    template<typename ...Args>
+    void write(const std::tuple<Args...>& val);
+
     template <typename T, typename ...Args>
     void write_args(const T & head, const Args&... args);
 
-    void write_args();
+    void write_args() {}
+
+    template <typename ...Args>
+    void write_fields(const Args&... args);
 
-    bool read(char * data, int len);
+    bool read(char * data, int64_t len);
     bool read(bool & value);
     bool read(char & value);
     bool read(int32_t & value);
     bool read(int64_t & value);
+    bool read(int8_t & value);
+    bool read(uint8_t & value);
+    bool read(int16_t & value);
+    bool read(uint16_t & value);
+    bool read(uint32_t & value);
+    bool read(uint64_t & value);
     bool read(float & value);
     bool read(double & value);
     bool read(string & value);
+    bool read(StringView & value);
     bool read(Serializable & value);
 
+    template<typename T>
+    typename std::enable_if<Reflect<T>::value, bool>::type read(T & value);
+
+    template<typename Alloc>
+    bool read(std::basic_string<char, std::char_traits<char>, Alloc>& val);
+
+    template<typename T>
+    bool read(ArrayView<T>& val);
+
     template<typename T, typename Alloc = std::allocator<T>>
     bool read(std::vector<T, Alloc>& val);
 
@@ -98,28 +213,197 @@ public:
     template<typename K, typename Compare = std::less<K>, typename Alloc = std::allocator<K>>
     bool read(std::set<K, Compare, Alloc>& val);
 
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<std::pair<const K, V>>>
+    bool read(std::unordered_map<K, V, Hash, Equal, Alloc>& val);
+
+    template<typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<K>>
+    bool read(std::unordered_set<K, Hash, Equal, Alloc>& val);
+
+    template<typename T, typename Alloc = std::allocator<T>>
+    bool read(std::deque<T, Alloc>& val);
+
+    template<typename T, size_t N>
+    bool read(std::array<T, N>& val);
+
+    template<typename A, typename B>
+    bool read(std::pair<A, B>& val);
+
+    template<typename ...Args>
+    bool read(std::tuple<Args...>& val);
+
     template <typename T, typename ...Args>
     bool read_args(T & head, Args&... args);
 
-    bool read_args();
+    bool read_args() { return true; }
+
+    template <typename ...Args>
+    bool read_fields(Args&... args);
+
+    // an OBJECT tag and the byte length of the fields that follow, tagged
+    // (SERIALIZE) or untagged (SERIALIZE_SCHEMA); readers also accept the
+    // older unsized CUSTOM tag
+    template <typename ...Args>
+    void write_object(const Args&... args);
+
+    template <typename ...Args>
+    void write_schema(const Args&... args);
+
+    template <typename ...Args>
+    bool read_object(Args&... args);
+
+    template <typename ...Args>
+    bool read_schema(Args&... args);
+
+    // steps over one value of any type without decoding it; an OBJECT is
+    // skipped in one go by its length, an unsized CUSTOM cannot be skipped
+    bool skip();
+
+    // consumes an object header so its fields can be read or skipped one by one
+    bool open_object();
+
+    // positions the stream at field index of the object, or element index of
+    // the vector, that starts here: through the offset table when it was
+    // written indexed, by skipping the entries before it otherwise
+    bool seek_field(int index);
+    bool seek_element(int64_t index);
+
+    int64_t tell() const;
+    bool seek(int64_t pos);
+
+    // incremental decoding: a read that runs out of data returns false with
+    // partial() set and keeps what it has decoded so far; calling the same
+    // read with the same target after feed() resumes where it stopped
+    void set_incremental(bool incremental);
+    bool partial() const;
+    void feed(const char * data, int64_t len);
+
+    void attach(const char * data, int64_t len);
+
+    void set_compact(bool compact);
+    bool compact() const;
+
+    // byte order of fixed-width values on the wire, little endian by default;
+    // values are only swapped when it differs from the host
+    void set_byteorder(ByteOrder order);
+    ByteOrder byteorder() const;
+
+    // a short tagged string seen within the last 64KB is written as the
+    // distance back to that copy instead of in full; any reader resolves the
+    // references, an incremental one needs it set as well so that feed keeps
+    // those 64KB, and vectors are not encoded in parallel while it is on
+    void set_interned(bool interned);
+    bool interned() const;
+
+    // objects, maps, sets and vectors of tagged values are written with a
+    // table of entry offsets so that seek_field and seek_element need not
+    // scan, and large containers can be decoded in parallel
+    void set_indexed(bool indexed);
+    bool indexed() const;
+
+    // vectors of tagged values with at least two grains of elements are
+    // encoded in chunks on up to threads threads (0 for one per core) and
+    // copied out in order, byte for byte what one thread would write;
+    // indexed vectors, maps and sets that large are decoded the same way,
+    // each chunk found through the offset table
+    void set_threads(int threads, int grain = 4096);
+    int threads() const;
+
+    // streaming output: the buffer is flushed to the sink whenever it fills,
+    // so memory stays around chunk bytes however large the payload gets. on
+    // a sink that cannot be patched (see Sink::seekable) objects are written
+    // unsized as CUSTOM, which skip() cannot step over, and containers
+    // without an offset table, unless they sit inside something held back
+    // anyway: a begin_container container, an indexed one on a seekable
+    // sink, or a record, since its header comes first
+    void set_sink(Sink * sink, int chunk = 64 << 10);
+    bool flush();
+
+    // scatter-gather output: string and packed array payloads of at least
+    // threshold bytes (0 for none) are referenced where they live instead of
+    // being copied, so they must stay unchanged until the stream is sent;
+    // iovecs lists the encoded bytes and those payloads in order and returns
+    // their total, data() and size() only cover the copied bytes, and a
+    // stream with a sink copies everything
+    void set_gather(int64_t threshold);
+    int64_t gather() const;
+    int64_t iovecs(std::vector<struct iovec> & out) const;
+    bool writev(int fd) const;
+
+    // containers whose length is only known once written: begin returns the
+    // position of the length prefix and end fills it in
+    int64_t begin_container(char type);
+    bool end_container(int64_t mark, int64_t len);
+
+    // length-delimited records: a 4 byte little endian payload length, with
+    // the top bit set when a CRC-32C of the payload follows; with a sink each
+    // record is buffered whole until end_record, which throws length_error
+    // for a payload of 2GB or more and leaves the stream as it was before
+    // begin_record
+    int64_t begin_record(bool checksum = false);
+    void end_record(int64_t mark);
+
+    template <typename T>
+    void write_record(const T & value, bool checksum = false);
+
+    template <typename Iterator>
+    void write_records(Iterator first, Iterator last, bool checksum = false);
+
+    // hands out the next record's payload without decoding it; read_record
+    // verifies the checksum, skip_record does not look at the payload at all
+    bool read_record(StringView & payload);
+    bool skip_record();
 
     const char * data() const;
-    int size() const;
+    int64_t size() const;
+
+    // clear empties the stream for writing again and keeps the buffer's
+    // capacity, reset only rewinds reading to the start
     void clear();
     void reset();
+
+    // swap hands the encoded bytes over in buf, trimmed to size(), and
+    // adopts buf's bytes in their place to read from the start, each side
+    // keeping its storage; release moves the bytes out and leaves the
+    // stream empty. neither copies unless the stream is attached or mapped,
+    // gathered payloads are not part of the bytes and a stream with a sink
+    // only holds what has not been flushed yet
+    void swap(Buffer & buf);
+    Buffer release();
     void save(const string & filename);
     void load(const string & filename);
+    void map(const string & filename);
+
+    // saves a block compressed container (see Compress.h), compressed on
+    // threads() threads; load and map recognise one and decompress it the
+    // same way, leaving the stream empty if it is damaged
+    void save(const string & filename, Codec codec, int block = 64 << 10);
 
     DataStream & operator << (bool value);
     DataStream & operator << (char value);
     DataStream & operator << (int32_t value);
     DataStream & operator << (int64_t value);
+    DataStream & operator << (int8_t value);
+    DataStream & operator << (uint8_t value);
+    DataStream & operator << (int16_t value);
+    DataStream & operator << (uint16_t value);
+    DataStream & operator << (uint32_t value);
+    DataStream & operator << (uint64_t value);
     DataStream & operator << (float value);
     DataStream & operator << (double value);
     DataStream & operator << (const char * value);
     DataStream & operator << (const string & value);
+    DataStream & operator << (const StringView & value);
     DataStream & operator << (const Serializable & value);
 
+    template<typename T>
+    typename std::enable_if<Reflect<T>::value, DataStream &>::type operator << (const T & value);
+
+    template<typename Alloc>
+    DataStream & operator << (const std::basic_string<char, std::char_traits<char>, Alloc> & value);
+
+    template<typename T>
+    DataStream & operator << (const ArrayView<T> & value);
+
     template<typename T, typename Alloc = std::allocator<T>>
     DataStream & operator << (const std::vector<T, Alloc> & value);
 
@@ -132,15 +416,49 @@ public:
     template<typename K, typename Compare = std::less<K>, typename Alloc = std::allocator<K>>
     DataStream & operator << (const std::set<K, Compare, Alloc> & value);
 
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<std::pair<const K, V>>>
+    DataStream & operator << (const std::unordered_map<K, V, Hash, Equal, Alloc> & value);
+
+    template<typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<K>>
+    DataStream & operator << (const std::unordered_set<K, Hash, Equal, Alloc> & value);
+
+    template<typename T, typename Alloc = std::allocator<T>>
+    DataStream & operator << (const std::deque<T, Alloc> & value);
+
+    template<typename T, size_t N>
+    DataStream & operator << (const std::array<T, N> & value);
+
+    template<typename A, typename B>
+    DataStream & operator << (const std::pair<A, B> & value);
+
+    template<typename ...Args>
+    DataStream & operator << (const std::tuple<Args...> & value);
+
     DataStream & operator >> (bool & value);
     DataStream & operator >> (char & value);
     DataStream & operator >> (int32_t & value);
     DataStream & operator >> (int64_t & value);
+    DataStream & operator >> (int8_t & value);
+    DataStream & operator >> (uint8_t & value);
+    DataStream & operator >> (int16_t & value);
+    DataStream & operator >> (uint16_t & value);
+    DataStream & operator >> (uint32_t & value);
+    DataStream & operator >> (uint64_t & value);
     DataStream & operator >> (float & value);
     DataStream & operator >> (double & value);
     DataStream & operator >> (string & value);
+    DataStream & operator >> (StringView & value);
     DataStream & operator >> (Serializable & value);
 
+    template<typename T>
+    typename std::enable_if<Reflect<T>::value, DataStream &>::type operator >> (T & value);
+
+    template<typename Alloc>
+    DataStream & operator >> (std::basic_string<char, std::char_traits<char>, Alloc> & value);
+
+    template<typename T>
+    DataStream & operator >> (ArrayView<T> & value);
+
     template<typename T, typename Alloc = std::allocator<T>>
     DataStream & operator >> (std::vector<T, Alloc> & value);
 
@@ -153,172 +471,2380 @@ public:
     template<typename K, typename Compare = std::less<K>, typename Alloc = std::allocator<K>>
     DataStream & operator >> (std::set<K, Compare, Alloc> & value);
 
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<std::pair<const K, V>>>
+    DataStream & operator >> (std::unordered_map<K, V, Hash, Equal, Alloc> & value);
+
+    template<typename K, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>, typename Alloc = std::allocator<K>>
+    DataStream & operator >> (std::unordered_set<K, Hash, Equal, Alloc> & value);
+
+    template<typename T, typename Alloc = std::allocator<T>>
+    DataStream & operator >> (std::deque<T, Alloc> & value);
+
+    template<typename T, size_t N>
+    DataStream & operator >> (std::array<T, N> & value);
+
+    template<typename A, typename B>
+    DataStream & operator >> (std::pair<A, B> & value);
+
+    template<typename ...Args>
+    DataStream & operator >> (std::tuple<Args...> & value);
+
 private:
-    void reserve(int len);
-    ByteOrder byteorder();
+    void reserve(int64_t len);
+    bool swapped() const;
+    bool unsized() const;
+    bool indexing() const;
+    void save_file(const string & filename, const char * buf, size_t left);
+    void unpack(const char * data, int64_t len);
+    void write_sink(const char * data, int64_t len);
+    void write_payload(const char * data, int64_t len);
+    int64_t borrowed_since(int64_t mark) const;
+
+    template<typename T>
+    void write_tagged(char type, T value);
+
+    template<typename T>
+    bool read_tagged(char type, T & value);
+
+    bool peek(char type);
+
+    bool write_ref(const char * data, int64_t len);
+    bool read_ref(StringView & value);
+    void forget_strings();
+
+    struct Frame
+    {
+        int64_t len;
+        int64_t done;
+    };
+
+    bool enter(char type, int64_t & len, int64_t & done);
+    bool leave(bool ok, int64_t done);
+    bool resuming() const;
+    void rewind(int64_t pos);
+
+    void write_varint(uint64_t value);
+    void write_varint(char type, uint64_t value);
+    bool read_varint(uint64_t & value);
+    bool read_varint(char type, uint64_t & value);
+    void write_compact(char type, int64_t value);
+    bool read_compact(char type, int64_t & value);
+
+    void write_length(int64_t len);
+    int encode_length(char * buf, int64_t len);
+    bool widen_length(int64_t mark, int64_t len);
+    void write_array(const char * data, int64_t len, int width);
+    void read_array(char * data, int64_t len, int width);
+    bool read_length(int64_t & len);
+
+    template <typename ...Args>
+    void write_fixed_fields(std::true_type, const Args&... args);
+
+    template <typename ...Args>
+    void write_fixed_fields(std::false_type, const Args&... args);
+
+    template <typename ...Args>
+    bool read_fixed_fields(std::true_type, Args&... args);
+
+    template <typename ...Args>
+    bool read_fixed_fields(std::false_type, Args&... args);
+
+    template <typename ...Args>
+    void write_schema(std::true_type, const Args&... args);
+
+    template <typename ...Args>
+    void write_schema(std::false_type, const Args&... args);
+
+    int64_t begin_object();
+    void end_object(int64_t mark);
+    bool read_header(int64_t & len);
+    bool read_sized_header(int64_t & len);
+    bool skip_value();
+    bool skip_bytes(int64_t len);
+
+    struct Index
+    {
+        int64_t mark;
+        int64_t table;
+        int64_t count;
+    };
+
+    Index begin_index(char kind, int64_t count);
+
+    template <typename ...Args>
+    void write_indexed(const Args&... args);
+
+    template <typename ...Args>
+    void write_indexed_fields(const Args&... args);
+
+    void index_entry(const Index & index, int64_t i, int64_t ahead = 0);
+    void end_index(const Index & index);
+    bool read_index(char kind, int64_t & len, int64_t & count, int64_t & table);
+    bool seek_entry(char kind, int64_t index);
+
+    template <typename ...Args>
+    bool read_schema(std::true_type, Args&... args);
+
+    template <typename ...Args>
+    bool read_schema(std::false_type, Args&... args);
+
+    template <typename T, typename ...Args>
+    void store_fields(char * buf, const T & head, const Args&... args);
+    void store_fields(char * buf) {}
+
+    template <typename T, typename ...Args>
+    void load_fields(const char * buf, T & head, Args&... args);
+    void load_fields(const char * buf) {}
+
+    template <typename T>
+    void load_field(const char * buf, T & value);
+    void load_field(const char * buf, bool & value);
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value>::type write_field(const T & value);
+    void write_field(const string & value);
+    void write_field(const StringView & value);
+    void write_field(const Serializable & value);
+
+    template <typename T>
+    typename std::enable_if<Reflect<T>::value>::type write_field(const T & value);
+
+    template<typename Alloc>
+    void write_field(const std::basic_string<char, std::char_traits<char>, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    void write_field(const std::vector<T, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    void write_field(const std::list<T, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    void write_field_array(const std::vector<T, Alloc>& value, std::true_type);
+
+    template<typename T, typename Alloc>
+    void write_field_array(const std::vector<T, Alloc>& value, std::false_type);
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    void write_field(const std::map<K, V, Compare, Alloc>& value);
+
+    template<typename K, typename Compare, typename Alloc>
+    void write_field(const std::set<K, Compare, Alloc>& value);
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+    void write_field(const std::unordered_map<K, V, Hash, Equal, Alloc>& value);
+
+    template<typename K, typename Hash, typename Equal, typename Alloc>
+    void write_field(const std::unordered_set<K, Hash, Equal, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    void write_field(const std::deque<T, Alloc>& value);
+
+    template<typename T, size_t N>
+    void write_field(const std::array<T, N>& value);
+
+    template<typename A, typename B>
+    void write_field(const std::pair<A, B>& value);
+
+    template<typename ...Args>
+    void write_field(const std::tuple<Args...>& value);
+
+    template <typename T>
+    typename std::enable_if<std::is_arithmetic<T>::value, bool>::type read_field(T & value);
+    bool read_field(string & value);
+    bool read_field(StringView & value);
+    bool read_field(Serializable & value);
+
+    template <typename T>
+    typename std::enable_if<Reflect<T>::value, bool>::type read_field(T & value);
+
+    template<typename Alloc>
+    bool read_field(std::basic_string<char, std::char_traits<char>, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    bool read_field(std::vector<T, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    bool read_field(std::list<T, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    bool read_field_array(std::vector<T, Alloc>& value, int64_t len, std::true_type);
+
+    template<typename T, typename Alloc>
+    bool read_field_array(std::vector<T, Alloc>& value, int64_t len, std::false_type);
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    bool read_field(std::map<K, V, Compare, Alloc>& value);
+
+    template<typename K, typename Compare, typename Alloc>
+    bool read_field(std::set<K, Compare, Alloc>& value);
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+    bool read_field(std::unordered_map<K, V, Hash, Equal, Alloc>& value);
+
+    template<typename K, typename Hash, typename Equal, typename Alloc>
+    bool read_field(std::unordered_set<K, Hash, Equal, Alloc>& value);
+
+    template<typename T, typename Alloc>
+    bool read_field(std::deque<T, Alloc>& value);
+
+    template<typename T, size_t N>
+    bool read_field(std::array<T, N>& value);
+
+    template<typename A, typename B>
+    bool read_field(std::pair<A, B>& value);
+
+    template<typename ...Args>
+    bool read_field(std::tuple<Args...>& value);
+
+    // the bodies shared by containers with the same encoding
+    template<typename C>
+    void write_sequence(char type, const C& value);
+
+    template<typename C>
+    bool read_sequence(char type, C& value);
+
+    template<typename M>
+    void write_map(const M& value);
+
+    template<typename M>
+    bool read_map(M& value);
+
+    template<typename S>
+    void write_set(const S& value);
+
+    template<typename S>
+    bool read_set(S& value);
+
+    template<typename C>
+    void write_field_sequence(const C& value, std::true_type);
+
+    template<typename C>
+    void write_field_sequence(const C& value, std::false_type);
+
+    template<typename C>
+    bool read_field_sequence(C& value, std::true_type);
+
+    template<typename C>
+    bool read_field_sequence(C& value, std::false_type);
+
+    template<typename Iterator>
+    bool read_field_elements(Iterator first, int64_t len, std::true_type);
+
+    template<typename Iterator>
+    bool read_field_elements(Iterator first, int64_t len, std::false_type);
+
+    template<typename M>
+    void write_field_map(const M& value);
+
+    template<typename M>
+    bool read_field_map(M& value);
+
+    template<typename S>
+    void write_field_set(const S& value);
+
+    template<typename S>
+    bool read_field_set(S& value);
+
+    template<typename T>
+    void write_packed(const T * first, int64_t len);
+
+    template<typename Iterator>
+    void write_packed(Iterator first, int64_t len);
+
+    template<typename T>
+    void read_packed(T * first, int64_t len);
+
+    template<typename Iterator>
+    void read_packed(Iterator first, int64_t len);
+
+    template<typename T, typename Alloc>
+    void write_deque(const std::deque<T, Alloc>& value, std::true_type);
+
+    template<typename T, typename Alloc>
+    void write_deque(const std::deque<T, Alloc>& value, std::false_type);
+
+    template<typename T, typename Alloc>
+    bool read_deque(std::deque<T, Alloc>& value, std::true_type);
+
+    template<typename T, typename Alloc>
+    bool read_deque(std::deque<T, Alloc>& value, std::false_type);
+
+    template<typename T, size_t N>
+    void write_fixed(const std::array<T, N>& value, std::true_type);
+
+    template<typename T, size_t N>
+    void write_fixed(const std::array<T, N>& value, std::false_type);
+
+    template<typename T, size_t N>
+    bool read_fixed(std::array<T, N>& value, std::true_type);
+
+    template<typename T, size_t N>
+    bool read_fixed(std::array<T, N>& value, std::false_type);
+
+    template<typename Tuple, size_t ...I>
+    void write_tuple(const Tuple& value, Indices<I...>);
+
+    template<typename Tuple, size_t ...I>
+    bool read_tuple(Tuple& value, Indices<I...>);
+
+    template<typename Tuple, size_t ...I>
+    void write_field_tuple(const Tuple& value, Indices<I...>);
+
+    template<typename Tuple, size_t ...I>
+    bool read_field_tuple(Tuple& value, Indices<I...>);
+
+    template<typename T, typename Alloc>
+    void write_vector(const std::vector<T, Alloc>& value, std::true_type);
+
+    template<typename T, typename Alloc>
+    void write_vector(const std::vector<T, Alloc>& value, std::false_type);
+
+    template<typename T, typename Alloc>
+    void write_parallel(const std::vector<T, Alloc>& value);
+
+    int64_t parallel_count(char kind);
+    bool read_chunks(char kind, const std::function<bool(DataStream &, int64_t, int64_t)>& task);
+
+    template<typename T, typename Alloc>
+    bool read_vector(std::vector<T, Alloc>& value, std::true_type);
+
+    template<typename T, typename Alloc>
+    bool read_vector(std::vector<T, Alloc>& value, std::false_type);
 
 private:
-    std::vector<char> m_buf;
-    int m_pos;
+    Buffer m_buf;
+    BufferPool * m_pool;
+    int64_t m_size;
+    const char * m_view;
+    int64_t m_viewlen;
+    std::shared_ptr<void> m_mapping;
+    int64_t m_pos;
     ByteOrder m_byteorder;
+    bool m_compact;
+    bool m_indexed;
+    bool m_interned;
+    int m_threads;
+    int m_grain;
+    std::vector<Buffer> m_parts;
+
+    // the last position of each short string written, one per hash slot
+    struct Interned
+    {
+        int64_t pos;
+        string text;
+    };
+    std::vector<Interned> m_strings;
+
+    // a payload borrowed in front of buffer position pos, and the borrowed
+    // bytes before it
+    struct Segment
+    {
+        int64_t pos;
+        const char * data;
+        int64_t len;
+        int64_t before;
+    };
+    int64_t m_gather;
+    std::vector<Segment> m_segments;
+    int64_t m_borrowed;
+    Sink * m_sink;
+    int64_t m_flushed;
+    int64_t m_hold;
+    int m_open;
+    bool m_sink_ok;
+    bool m_unsized;
+    bool m_incremental;
+    bool m_partial;
+    int m_depth;
+    std::vector<Frame> m_frames;
 };
 
-template<typename T, typename Alloc>
-void DataStream::write(const std::vector<T, Alloc>& value) {
-    char type = DataType::VECTOR;
-    write(reinterpret_cast<char*>(&type), sizeof(char));
-    int len = value.size();
-    write(len);
-    for (auto& item : value) {
-        write(item);
+inline const char * DataStream::data() const
+{
+    if (m_view != NULL)
+    {
+        return m_view;
     }
+    return m_buf.data();
 }
 
-template<typename T, typename Alloc>
-void DataStream::write(const std::list<T, Alloc>& value)
+inline int64_t DataStream::size() const
 {
-    char type = DataType::LIST;
-    write(reinterpret_cast<char*>(&type), sizeof(char));
-    int len = value.size();
-    write(len);
-    for (auto& item : value){ 
-        write(item);
+    if (m_view != NULL)
+    {
+        return m_viewlen;
     }
+    return m_size;
 }
 
-template<typename K, typename V, typename Compare, typename Alloc>
-void DataStream::write(const std::map<K, V, Compare, Alloc>& value)
+// the host order is a compile time constant, only the wire order is read;
+// a native wire is the case worth laying out straight
+inline bool DataStream::swapped() const
 {
-    char type = DataType::MAP;
-    write(reinterpret_cast<char*>(&type), sizeof(char));
-    int len = value.size();
-    write(len);
-    for (auto it = value.begin(); it != value.end(); it++)
-    {
-        write(it->first);
-        write(it->second);
-    }
+    return __builtin_expect((m_byteorder == ByteOrder::BigEndian) != kHostBigEndian, 0);
 }
 
-template<typename K, typename Compare, typename Alloc>
-void DataStream::write(const std::set<K, Compare, Alloc>& value)
+// an offset table is filled in as its entries are written, on a sink that
+// cannot be patched that would hold the whole container back unless
+// something around it is held back already
+inline bool DataStream::unsized() const
 {
-    char type = DataType::SET;
-    write((char *)&type, sizeof(char));
-    int len = value.size();
-    write(len);
-    for (auto it = value.begin(); it != value.end(); it++)
-    {
-        write(*it);
-    }
+    return m_unsized && m_hold < 0;
 }
 
-template <typename T, typename ...Args>
-void DataStream::write_args(const T & head, const Args&... args)
+inline bool DataStream::indexing() const
 {
-    write(head);
-    write_args(args...);
+    return m_indexed && !unsized();
 }
 
-template<typename T, typename Alloc>
-bool DataStream::read(std::vector<T, Alloc>& value)
+template<typename T>
+inline void DataStream::write_tagged(char type, T value)
 {
-    value.clear();
-    if (m_buf[m_pos] != DataType::VECTOR)
+    if (m_view != NULL || m_size + 1 + (int)sizeof(T) > (int64_t)m_buf.size())
     {
-        return false;
+        reserve(1 + sizeof(T));
     }
-    ++m_pos;
-    int len;
-    read(len);
-    for (int i = 0; i < len; i++)
+    if (swapped())
     {
-        T v;
-        read(v);
-        value.push_back(v);
+        value = byteswap(value);
     }
-    return true;
+    char * buf = m_buf.data() + m_size;
+    buf[0] = type;
+    std::memcpy(buf + 1, &value, sizeof(T));
+    m_size += 1 + sizeof(T);
 }
 
-template<typename T, typename Alloc>
-bool DataStream::read(std::list<T, Alloc>& value)
+template<typename T>
+inline bool DataStream::read_tagged(char type, T & value)
 {
-    value.clear();
-    if (m_buf[m_pos] != DataType::LIST)
+    if (size() - m_pos < 1 + (int)sizeof(T) || data()[m_pos] != type)
     {
+        m_partial = m_pos >= size() || data()[m_pos] == type;
         return false;
     }
-    ++m_pos;
-    int len;
-    read(len);
-    for (int i = 0; i < len; i++)
+    std::memcpy(&value, data() + m_pos + 1, sizeof(T));
+    if (swapped())
     {
-        T v;
-        read(v);
-        value.push_back(v);
+        value = byteswap(value);
     }
+    m_pos += 1 + sizeof(T);
     return true;
 }
 
-template<typename K, typename V, typename Compare, typename Alloc>
-bool DataStream::read(std::map<K, V, Compare, Alloc>& value)
+// scalars are defined inline so that nested objects inline all the way down;
+// compact integers go out of line to the varint codec
+inline void DataStream::write(bool value)
 {
-    value.clear();
-    if (m_buf[m_pos] != DataType::MAP)
-    {
-        return false;
-    }
-    ++m_pos;
-    int len;
-    read(len);
-    for (int i = 0; i < len; i++)
-    {
-        K k;
-        read(k);
+    write_tagged(DataType::BOOL, value);
+}
 
-        V v;
-        read(v);
-        value[k] = v;
-    }
-    return true;
+inline void DataStream::write(char value)
+{
+    write_tagged(DataType::CHAR, value);
 }
 
-template<typename K, typename Compare, typename Alloc>
-bool DataStream::read(std::set<K, Compare, Alloc>& value)
+inline void DataStream::write(int32_t value)
 {
-    value.clear();
-    if (m_buf[m_pos] != DataType::SET)
+    if (m_compact)
     {
-        return false;
+        write_compact(DataType::INT32, value);
+        return;
     }
-    ++m_pos;
-    int len;
-    read(len);
-    for (int i = 0; i < len; i++)
+    write_tagged(DataType::INT32, value);
+}
+
+inline void DataStream::write(int64_t value)
+{
+    if (m_compact)
     {
-        K v;
-        read(v);
-        value.insert(v);
+        write_compact(DataType::INT64, value);
+        return;
     }
-    return true;
+    write_tagged(DataType::INT64, value);
 }
 
-template <typename T, typename ...Args>
-bool DataStream::DataStream::read_args(T & head, Args&... args)
+// 8-bit values are a tag and a byte either way, wider ones are varints in
+// compact mode, zigzagged only when signed
+inline void DataStream::write(int8_t value)
 {
-    read(head);
-    return read_args(args...);
+    write_tagged(DataType::INT8, value);
 }
 
-template<typename T, typename Alloc>
-DataStream & DataStream::operator << (const std::vector<T, Alloc> & value)
+inline void DataStream::write(uint8_t value)
 {
-    write(value);
-    return *this;
+    write_tagged(DataType::UINT8, value);
 }
 
-template<typename T, typename Alloc>
-DataStream & DataStream::operator << (const std::list<T, Alloc> & value) {
+inline void DataStream::write(int16_t value)
+{
+    if (m_compact)
+    {
+        write_compact(DataType::INT16, value);
+        return;
+    }
+    write_tagged(DataType::INT16, value);
+}
+
+inline void DataStream::write(uint16_t value)
+{
+    if (m_compact)
+    {
+        write_varint(DataType::UINT16, value);
+        return;
+    }
+    write_tagged(DataType::UINT16, value);
+}
+
+inline void DataStream::write(uint32_t value)
+{
+    if (m_compact)
+    {
+        write_varint(DataType::UINT32, value);
+        return;
+    }
+    write_tagged(DataType::UINT32, value);
+}
+
+inline void DataStream::write(uint64_t value)
+{
+    if (m_compact)
+    {
+        write_varint(DataType::UINT64, value);
+        return;
+    }
+    write_tagged(DataType::UINT64, value);
+}
+
+inline void DataStream::write(float value)
+{
+    write_tagged(DataType::FLOAT, value);
+}
+
+inline void DataStream::write(double value)
+{
+    write_tagged(DataType::DOUBLE, value);
+}
+
+inline bool DataStream::read(bool & value)
+{
+    char c;
+    if (!read_tagged(DataType::BOOL, c))
+    {
+        return false;
+    }
+    value = c;
+    return true;
+}
+
+inline bool DataStream::read(char & value)
+{
+    return read_tagged(DataType::CHAR, value);
+}
+
+inline bool DataStream::read(int32_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::INT32, value);
+    }
+    int64_t n;
+    if (!read_compact(DataType::INT32, n))
+    {
+        return false;
+    }
+    if (n < INT32_MIN || n > INT32_MAX)
+    {
+        m_partial = false;
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+inline bool DataStream::read(int64_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::INT64, value);
+    }
+    return read_compact(DataType::INT64, value);
+}
+
+inline bool DataStream::read(int8_t & value)
+{
+    return read_tagged(DataType::INT8, value);
+}
+
+inline bool DataStream::read(uint8_t & value)
+{
+    return read_tagged(DataType::UINT8, value);
+}
+
+inline bool DataStream::read(int16_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::INT16, value);
+    }
+    int64_t n;
+    if (!read_compact(DataType::INT16, n))
+    {
+        return false;
+    }
+    if (n < INT16_MIN || n > INT16_MAX)
+    {
+        m_partial = false;
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+inline bool DataStream::read(uint16_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::UINT16, value);
+    }
+    uint64_t n;
+    if (!read_varint(DataType::UINT16, n))
+    {
+        return false;
+    }
+    if (n > UINT16_MAX)
+    {
+        m_partial = false;
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+inline bool DataStream::read(uint32_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::UINT32, value);
+    }
+    uint64_t n;
+    if (!read_varint(DataType::UINT32, n))
+    {
+        return false;
+    }
+    if (n > UINT32_MAX)
+    {
+        m_partial = false;
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+inline bool DataStream::read(uint64_t & value)
+{
+    if (!m_compact)
+    {
+        return read_tagged(DataType::UINT64, value);
+    }
+    return read_varint(DataType::UINT64, value);
+}
+
+inline bool DataStream::read(float & value)
+{
+    return read_tagged(DataType::FLOAT, value);
+}
+
+inline bool DataStream::read(double & value)
+{
+    return read_tagged(DataType::DOUBLE, value);
+}
+
+inline bool DataStream::peek(char type)
+{
+    if (m_pos < size() && data()[m_pos] == type)
+    {
+        return true;
+    }
+    m_partial = m_pos >= size();
+    return false;
+}
+
+inline bool DataStream::resuming() const
+{
+    return m_depth < (int)m_frames.size();
+}
+
+// the five byte prefix holds up to 2GB tagged and 32GB compact, 0 is
+// returned for a length that does not fit
+inline int DataStream::encode_length(char * buf, int64_t len)
+{
+    if (m_compact)
+    {
+        if (len >= (int64_t)1 << 35)
+        {
+            return 0;
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            buf[i] = (char)((((uint64_t)len >> (7 * i)) & 0x7f) | 0x80);
+        }
+        buf[4] = (char)(((uint64_t)len >> 28) & 0x7f);
+        return 5;
+    }
+    if (len > INT32_MAX)
+    {
+        return 0;
+    }
+    int32_t value = len;
+    if (swapped())
+    {
+        value = byteswap(value);
+    }
+    buf[0] = DataType::INT32;
+    std::memcpy(buf + 1, &value, sizeof(int32_t));
+    return 1 + sizeof(int32_t);
+}
+
+// lengths and offsets measured in buffer positions leave out borrowed
+// payloads, this is what to add back for everything after mark; a payload
+// borrowed right at mark was written before it, by the value in front
+inline int64_t DataStream::borrowed_since(int64_t mark) const
+{
+    int64_t pos = mark - m_flushed;
+    if (m_segments.empty() || m_segments.back().pos <= pos)
+    {
+        return 0;
+    }
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), pos, [](int64_t pos, const Segment & seg)
+    {
+        return pos < seg.pos;
+    });
+    return m_borrowed - it->before;
+}
+
+// without a sink the length is always patched in place; a sink that cannot
+// be patched gets the unsized CUSTOM form, so a large object is not held back
+inline int64_t DataStream::begin_object()
+{
+    if (unsized())
+    {
+        char type = DataType::CUSTOM;
+        write(&type, sizeof(char));
+        return -1;
+    }
+    if (m_sink != NULL)
+    {
+        return begin_container(DataType::OBJECT);
+    }
+    if (m_view != NULL || m_size + 6 > (int64_t)m_buf.size())
+    {
+        reserve(6);
+    }
+    char * buf = m_buf.data() + m_size;
+    buf[0] = DataType::OBJECT;
+    m_size += 1 + encode_length(buf + 1, 0);
+    return m_flushed + m_size - 5;
+}
+
+inline void DataStream::end_object(int64_t mark)
+{
+    if (mark < 0)
+    {
+        return;
+    }
+    int64_t len = m_flushed + m_size - mark - 5 + borrowed_since(mark);
+    if (m_sink != NULL)
+    {
+        end_container(mark, len);
+        return;
+    }
+    if (encode_length(m_buf.data() + (mark - m_flushed), len) == 0)
+    {
+        widen_length(mark, len);
+    }
+}
+
+// the common fixed width OBJECT header is decoded inline, anything else
+// (compact prefix, unsized CUSTOM, short or malformed data) goes the long way
+inline bool DataStream::read_header(int64_t & len)
+{
+    const char * buf = data() + m_pos;
+    if (!m_compact && size() - m_pos >= 6 && buf[0] == DataType::OBJECT && buf[1] == DataType::INT32)
+    {
+        int32_t value;
+        load_field(buf + 2, value);
+        if (value >= 0 && value <= size() - m_pos - 6)
+        {
+            len = value;
+            m_pos += 6;
+            return true;
+        }
+    }
+    return read_sized_header(len);
+}
+
+// element types whose vectors are encoded as one packed ARRAY block
+template<typename T>
+struct ArrayTraits
+{
+    static const bool packed = false;
+};
+
+template<> struct ArrayTraits<char> { static const bool packed = true; static const char type = DataStream::CHAR; };
+template<> struct ArrayTraits<int32_t> { static const bool packed = true; static const char type = DataStream::INT32; };
+template<> struct ArrayTraits<int64_t> { static const bool packed = true; static const char type = DataStream::INT64; };
+template<> struct ArrayTraits<int8_t> { static const bool packed = true; static const char type = DataStream::INT8; };
+template<> struct ArrayTraits<uint8_t> { static const bool packed = true; static const char type = DataStream::UINT8; };
+template<> struct ArrayTraits<int16_t> { static const bool packed = true; static const char type = DataStream::INT16; };
+template<> struct ArrayTraits<uint16_t> { static const bool packed = true; static const char type = DataStream::UINT16; };
+template<> struct ArrayTraits<uint32_t> { static const bool packed = true; static const char type = DataStream::UINT32; };
+template<> struct ArrayTraits<uint64_t> { static const bool packed = true; static const char type = DataStream::UINT64; };
+template<> struct ArrayTraits<float> { static const bool packed = true; static const char type = DataStream::FLOAT; };
+template<> struct ArrayTraits<double> { static const bool packed = true; static const char type = DataStream::DOUBLE; };
+
+// hash containers are sized for their entries before decoding, ordered ones
+// have nothing to reserve
+template<typename C>
+inline void reserve_entries(C & value, int64_t len) {}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+inline void reserve_entries(std::unordered_map<K, V, Hash, Equal, Alloc> & value, int64_t len)
+{
+    value.reserve(len);
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+inline void reserve_entries(std::unordered_set<K, Hash, Equal, Alloc> & value, int64_t len)
+{
+    value.reserve(len);
+}
+
+template<typename T>
+typename std::enable_if<Reflect<T>::value>::type DataStream::write(const T & value)
+{
+    Reflect<T>::write(*this, value);
+}
+
+template<typename T>
+typename std::enable_if<Reflect<T>::value, bool>::type DataStream::read(T & value)
+{
+    return Reflect<T>::read(*this, value);
+}
+
+template <typename T>
+typename std::enable_if<Reflect<T>::value>::type DataStream::write_field(const T & value)
+{
+    Reflect<T>::write(*this, value);
+}
+
+template <typename T>
+typename std::enable_if<Reflect<T>::value, bool>::type DataStream::read_field(T & value)
+{
+    return Reflect<T>::read(*this, value);
+}
+
+template<typename Alloc>
+void DataStream::write(const std::basic_string<char, std::char_traits<char>, Alloc>& value)
+{
+    write(StringView(value.data(), value.size()));
+}
+
+template<typename T, typename Alloc>
+void DataStream::write(const std::vector<T, Alloc>& value)
+{
+    write_vector(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_vector(const std::vector<T, Alloc>& value, std::true_type)
+{
+    char header[2] = { DataType::ARRAY, ArrayTraits<T>::type };
+    write(header, sizeof(header));
+    int64_t len = value.size();
+    write_length(len);
+    write_array((const char *)value.data(), len * sizeof(T), sizeof(T));
+}
+
+template<typename T>
+void DataStream::write(const ArrayView<T>& value)
+{
+    char header[2] = { DataType::ARRAY, ArrayTraits<T>::type };
+    write(header, sizeof(header));
+    int64_t len = value.size();
+    write_length(len);
+    write_payload(value.bytes(), len * sizeof(T));
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_vector(const std::vector<T, Alloc>& value, std::false_type)
+{
+    if (m_threads > 1 && !m_interned && value.size() >= 2 * (size_t)m_grain)
+    {
+        write_parallel(value);
+        return;
+    }
+    if (indexing())
+    {
+        Index index = begin_index(DataType::VECTOR, value.size());
+        int64_t i = 0;
+        for (auto& item : value)
+        {
+            index_entry(index, i++);
+            write(item);
+        }
+        end_index(index);
+        return;
+    }
+    char type = DataType::VECTOR;
+    write(reinterpret_cast<char*>(&type), sizeof(char));
+    int64_t len = value.size();
+    write_length(len);
+    for (auto& item : value) {
+        write(item);
+    }
+}
+
+// each chunk is encoded into a stream of its own with the same settings;
+// elements do not depend on what precedes them, so the chunks only need
+// copying out behind the header, and the offset table shifting into place
+template<typename T, typename Alloc>
+void DataStream::write_parallel(const std::vector<T, Alloc>& value)
+{
+    int64_t len = value.size();
+    int chunks = std::min<int64_t>(len / m_grain, m_threads * 4);
+    std::unique_ptr<DataStream[]> parts(new DataStream[chunks]);
+    bool indexed = indexing();
+    std::vector<int64_t> starts(indexed ? len : 0);
+    // the chunk buffers are kept from one call to the next, so repeated
+    // dumps do not fault in fresh memory every time
+    m_parts.resize(std::max((int)m_parts.size(), chunks));
+    parallel_for(chunks, m_threads, [&](int c)
+    {
+        DataStream & part = parts[c];
+        part.m_buf.swap(m_parts[c]);
+        part.m_byteorder = m_byteorder;
+        part.m_compact = m_compact;
+        part.m_indexed = indexed;
+        part.m_unsized = unsized();
+        int64_t end = len * (c + 1) / chunks;
+        for (int64_t i = len * c / chunks; i < end; i++)
+        {
+            if (indexed)
+            {
+                starts[i] = part.m_size;
+            }
+            part.write(value[i]);
+        }
+    });
+    int64_t total = 16 + (indexed ? 4 * (int64_t)len : 0);
+    for (int c = 0; c < chunks; c++)
+    {
+        total += parts[c].size();
+    }
+    if (m_sink == NULL)
+    {
+        reserve(total);
+    }
+    if (!indexed)
+    {
+        char type = DataType::VECTOR;
+        write(&type, sizeof(char));
+        write_length(len);
+        for (int c = 0; c < chunks; c++)
+        {
+            write(parts[c].data(), parts[c].size());
+            m_parts[c].swap(parts[c].m_buf);
+        }
+        return;
+    }
+    Index index = begin_index(DataType::VECTOR, len);
+    for (int c = 0; c < chunks; c++)
+    {
+        int64_t end = len * (c + 1) / chunks;
+        for (int64_t i = len * c / chunks; i < end; i++)
+        {
+            index_entry(index, i, starts[i]);
+        }
+        write(parts[c].data(), parts[c].size());
+        m_parts[c].swap(parts[c].m_buf);
+    }
+    end_index(index);
+}
+
+template<typename T, typename Alloc>
+void DataStream::write(const std::list<T, Alloc>& value)
+{
+    write_sequence(DataType::LIST, value);
+}
+
+template<typename T, typename Alloc>
+void DataStream::write(const std::deque<T, Alloc>& value)
+{
+    write_deque(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+// a deque is encoded like a vector, packed element types as one ARRAY block
+template<typename T, typename Alloc>
+void DataStream::write_deque(const std::deque<T, Alloc>& value, std::true_type)
+{
+    char header[2] = { DataType::ARRAY, ArrayTraits<T>::type };
+    write(header, sizeof(header));
+    int64_t len = value.size();
+    write_length(len);
+    write_packed(value.begin(), len);
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_deque(const std::deque<T, Alloc>& value, std::false_type)
+{
+    write_sequence(DataType::VECTOR, value);
+}
+
+template<typename C>
+void DataStream::write_sequence(char type, const C& value)
+{
+    write(&type, sizeof(char));
+    int64_t len = value.size();
+    write_length(len);
+    for (auto& item : value)
+    {
+        write(item);
+    }
+}
+
+// contiguous values are one block straight from memory
+template<typename T>
+void DataStream::write_packed(const T * first, int64_t len)
+{
+    write_array((const char *)first, len * sizeof(T), sizeof(T));
+}
+
+// copies values out of non-contiguous storage a stack buffer at a time
+template<typename Iterator>
+void DataStream::write_packed(Iterator first, int64_t len)
+{
+    typedef typename std::iterator_traits<Iterator>::value_type T;
+    T buf[4096 / sizeof(T)];
+    while (len > 0)
+    {
+        int n = std::min<int64_t>(len, sizeof(buf) / sizeof(T));
+        for (int i = 0; i < n; i++)
+        {
+            buf[i] = *first++;
+        }
+        // buf is reused, so it is copied even when gathering
+        if (swapped())
+        {
+            write_array((const char *)buf, n * sizeof(T), sizeof(T));
+        }
+        else
+        {
+            write((const char *)buf, n * sizeof(T));
+        }
+        len -= n;
+    }
+}
+
+// a fixed size array of packed values is one block straight from memory
+template<typename T, size_t N>
+void DataStream::write(const std::array<T, N>& value)
+{
+    write_fixed(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename T, size_t N>
+void DataStream::write_fixed(const std::array<T, N>& value, std::true_type)
+{
+    char header[2] = { DataType::ARRAY, ArrayTraits<T>::type };
+    write(header, sizeof(header));
+    write_length(N);
+    write_packed(value.data(), N);
+}
+
+template<typename T, size_t N>
+void DataStream::write_fixed(const std::array<T, N>& value, std::false_type)
+{
+    write_sequence(DataType::VECTOR, value);
+}
+
+// pairs and tuples are objects whose fields are their members
+template<typename A, typename B>
+void DataStream::write(const std::pair<A, B>& value)
+{
+    write_object(value.first, value.second);
+}
+
+template<typename ...Args>
+void DataStream::write(const std::tuple<Args...>& value)
+{
+    write_tuple(value, typename MakeIndices<sizeof...(Args)>::type());
+}
+
+template<typename Tuple, size_t ...I>
+void DataStream::write_tuple(const Tuple& value, Indices<I...>)
+{
+    write_object(std::get<I>(value)...);
+}
+
+template<typename K, typename V, typename Compare, typename Alloc>
+void DataStream::write(const std::map<K, V, Compare, Alloc>& value)
+{
+    write_map(value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+void DataStream::write(const std::unordered_map<K, V, Hash, Equal, Alloc>& value)
+{
+    write_map(value);
+}
+
+template<typename M>
+void DataStream::write_map(const M& value)
+{
+    if (indexing())
+    {
+        Index index = begin_index(DataType::MAP, value.size());
+        int64_t i = 0;
+        for (auto it = value.begin(); it != value.end(); it++)
+        {
+            index_entry(index, i++);
+            write(it->first);
+            write(it->second);
+        }
+        end_index(index);
+        return;
+    }
+    char type = DataType::MAP;
+    write(reinterpret_cast<char*>(&type), sizeof(char));
+    int64_t len = value.size();
+    write_length(len);
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        write(it->first);
+        write(it->second);
+    }
+}
+
+template<typename K, typename Compare, typename Alloc>
+void DataStream::write(const std::set<K, Compare, Alloc>& value)
+{
+    write_set(value);
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+void DataStream::write(const std::unordered_set<K, Hash, Equal, Alloc>& value)
+{
+    write_set(value);
+}
+
+template<typename S>
+void DataStream::write_set(const S& value)
+{
+    if (indexing())
+    {
+        Index index = begin_index(DataType::SET, value.size());
+        int64_t i = 0;
+        for (auto it = value.begin(); it != value.end(); it++)
+        {
+            index_entry(index, i++);
+            write(*it);
+        }
+        end_index(index);
+        return;
+    }
+    char type = DataType::SET;
+    write((char *)&type, sizeof(char));
+    int64_t len = value.size();
+    write_length(len);
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        write(*it);
+    }
+}
+
+template <typename T>
+void DataStream::write_record(const T & value, bool checksum)
+{
+    int64_t mark = begin_record(checksum);
+    write(value);
+    end_record(mark);
+}
+
+template <typename Iterator>
+void DataStream::write_records(Iterator first, Iterator last, bool checksum)
+{
+    for (; first != last; ++first)
+    {
+        write_record(*first, checksum);
+    }
+}
+
+template <typename T, typename ...Args>
+void DataStream::write_args(const T & head, const Args&... args)
+{
+    write(head);
+    write_args(args...);
+}
+
+// untagged field encoding used by SERIALIZE_SCHEMA: scalars are stored raw in
+// the stream's byte order, strings and containers carry only their length prefix
+template <typename ...Args>
+void DataStream::write_fields(const Args&... args)
+{
+    write_fixed_fields(std::integral_constant<bool, FixedFields<Args...>::value>(), args...);
+}
+
+template <typename ...Args>
+void DataStream::write_fixed_fields(std::true_type, const Args&... args)
+{
+    const int len = FixedFields<Args...>::size;
+    if (m_view != NULL || m_size + len > (int64_t)m_buf.size())
+    {
+        reserve(len);
+    }
+    store_fields(m_buf.data() + m_size, args...);
+    m_size += len;
+}
+
+template <typename ...Args>
+void DataStream::write_fixed_fields(std::false_type, const Args&... args)
+{
+    int expand[] = { 0, (write_field(args), 0)... };
+    (void)expand;
+}
+
+template <typename ...Args>
+inline void DataStream::write_object(const Args&... args)
+{
+    if (indexing())
+    {
+        write_indexed(args...);
+        return;
+    }
+    int64_t mark = begin_object();
+    write_args(args...);
+    end_object(mark);
+}
+
+template <typename ...Args>
+void DataStream::write_indexed(const Args&... args)
+{
+    Index index = begin_index(DataType::CUSTOM, sizeof...(Args));
+    int i = 0;
+    int expand[] = { 0, (index_entry(index, i++), write(args), 0)... };
+    (void)expand;
+    end_index(index);
+}
+
+template <typename ...Args>
+void DataStream::write_indexed_fields(const Args&... args)
+{
+    Index index = begin_index(DataType::CUSTOM, sizeof...(Args));
+    int i = 0;
+    int expand[] = { 0, (index_entry(index, i++), write_field(args), 0)... };
+    (void)expand;
+    end_index(index);
+}
+
+template <typename ...Args>
+void DataStream::write_schema(const Args&... args)
+{
+    write_schema(std::integral_constant<bool, FixedFields<Args...>::value>(), args...);
+}
+
+// the length of a fixed layout is known up front, so nothing is patched
+template <typename ...Args>
+void DataStream::write_schema(std::true_type, const Args&... args)
+{
+    const int len = FixedFields<Args...>::size;
+    char header[8];
+    header[0] = DataType::OBJECT;
+    int n = 1 + encode_length(header + 1, len);
+    if (m_view != NULL || m_size + n + len > (int64_t)m_buf.size())
+    {
+        reserve(n + len);
+    }
+    char * buf = m_buf.data() + m_size;
+    std::memcpy(buf, header, n);
+    store_fields(buf + n, args...);
+    m_size += n + len;
+}
+
+template <typename ...Args>
+void DataStream::write_schema(std::false_type, const Args&... args)
+{
+    if (indexing())
+    {
+        write_indexed_fields(args...);
+        return;
+    }
+    int64_t mark = begin_object();
+    write_fixed_fields(std::false_type(), args...);
+    end_object(mark);
+}
+
+template <typename T, typename ...Args>
+void DataStream::store_fields(char * buf, const T & head, const Args&... args)
+{
+    T value = swapped() ? byteswap(head) : head;
+    std::memcpy(buf, &value, sizeof(T));
+    store_fields(buf + sizeof(T), args...);
+}
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type DataStream::write_field(const T & value)
+{
+    if (m_view != NULL || m_size + (int)sizeof(T) > (int64_t)m_buf.size())
+    {
+        reserve(sizeof(T));
+    }
+    store_fields(m_buf.data() + m_size, value);
+    m_size += sizeof(T);
+}
+
+template<typename Alloc>
+void DataStream::write_field(const std::basic_string<char, std::char_traits<char>, Alloc>& value)
+{
+    write_field(StringView(value.data(), value.size()));
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_field(const std::vector<T, Alloc>& value)
+{
+    write_length(value.size());
+    write_field_array(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_field_array(const std::vector<T, Alloc>& value, std::true_type)
+{
+    write_array((const char *)value.data(), value.size() * sizeof(T), sizeof(T));
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_field_array(const std::vector<T, Alloc>& value, std::false_type)
+{
+    for (auto& item : value)
+    {
+        write_field(item);
+    }
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_field(const std::list<T, Alloc>& value)
+{
+    write_field_sequence(value, std::false_type());
+}
+
+template<typename T, typename Alloc>
+void DataStream::write_field(const std::deque<T, Alloc>& value)
+{
+    write_field_sequence(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename T, size_t N>
+void DataStream::write_field(const std::array<T, N>& value)
+{
+    write_field_sequence(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename C>
+void DataStream::write_field_sequence(const C& value, std::true_type)
+{
+    write_length(value.size());
+    write_packed(value.begin(), value.size());
+}
+
+template<typename C>
+void DataStream::write_field_sequence(const C& value, std::false_type)
+{
+    write_length(value.size());
+    for (auto& item : value)
+    {
+        write_field(item);
+    }
+}
+
+template<typename A, typename B>
+void DataStream::write_field(const std::pair<A, B>& value)
+{
+    write_field(value.first);
+    write_field(value.second);
+}
+
+template<typename ...Args>
+void DataStream::write_field(const std::tuple<Args...>& value)
+{
+    write_field_tuple(value, typename MakeIndices<sizeof...(Args)>::type());
+}
+
+template<typename Tuple, size_t ...I>
+void DataStream::write_field_tuple(const Tuple& value, Indices<I...>)
+{
+    write_fields(std::get<I>(value)...);
+}
+
+template<typename K, typename V, typename Compare, typename Alloc>
+void DataStream::write_field(const std::map<K, V, Compare, Alloc>& value)
+{
+    write_field_map(value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+void DataStream::write_field(const std::unordered_map<K, V, Hash, Equal, Alloc>& value)
+{
+    write_field_map(value);
+}
+
+template<typename M>
+void DataStream::write_field_map(const M& value)
+{
+    write_length(value.size());
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        write_field(it->first);
+        write_field(it->second);
+    }
+}
+
+template<typename K, typename Compare, typename Alloc>
+void DataStream::write_field(const std::set<K, Compare, Alloc>& value)
+{
+    write_field_set(value);
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+void DataStream::write_field(const std::unordered_set<K, Hash, Equal, Alloc>& value)
+{
+    write_field_set(value);
+}
+
+template<typename S>
+void DataStream::write_field_set(const S& value)
+{
+    write_length(value.size());
+    for (auto it = value.begin(); it != value.end(); it++)
+    {
+        write_field(*it);
+    }
+}
+
+template <typename ...Args>
+bool DataStream::read_fields(Args&... args)
+{
+    return read_fixed_fields(std::integral_constant<bool, FixedFields<Args...>::value>(), args...);
+}
+
+template <typename ...Args>
+bool DataStream::read_fixed_fields(std::true_type, Args&... args)
+{
+    const int len = FixedFields<Args...>::size;
+    if (size() - m_pos < len)
+    {
+        m_partial = true;
+        return false;
+    }
+    load_fields(data() + m_pos, args...);
+    m_pos += len;
+    return true;
+}
+
+template <typename ...Args>
+bool DataStream::read_fixed_fields(std::false_type, Args&... args)
+{
+    bool ok = true;
+    int expand[] = { 0, (ok = ok && read_field(args), 0)... };
+    (void)expand;
+    return ok;
+}
+
+template <typename ...Args>
+inline bool DataStream::read_object(Args&... args)
+{
+    if (!m_incremental)
+    {
+        int64_t len;
+        return read_header(len) && read_args(args...);
+    }
+    int64_t len = sizeof...(Args);
+    int64_t done;
+    if (!enter(DataType::CUSTOM, len, done))
+    {
+        return false;
+    }
+    // fields before done were decoded by an earlier, partial call
+    int index = 0;
+    bool ok = true;
+    int expand[] = { 0, (ok = ok && (index < done || read(args)) && ++index, 0)... };
+    (void)expand;
+    return leave(ok, index);
+}
+
+template <typename ...Args>
+bool DataStream::read_schema(Args&... args)
+{
+    return read_schema(std::integral_constant<bool, FixedFields<Args...>::value>(), args...);
+}
+
+template <typename ...Args>
+bool DataStream::read_schema(std::true_type, Args&... args)
+{
+    const int len = FixedFields<Args...>::size;
+    // a fixed layout always carries the same header, the common fixed width
+    // one is checked inline and anything else goes the long way
+    const char * buf = data() + m_pos;
+    int32_t prefix = -1;
+    if (!m_compact && size() - m_pos >= 6 + len && buf[0] == DataType::OBJECT && buf[1] == DataType::INT32)
+    {
+        load_field(buf + 2, prefix);
+    }
+    if (prefix == len)
+    {
+        buf += 6;
+    }
+    else
+    {
+        int64_t pos = m_pos;
+        int64_t body;
+        if (!read_sized_header(body))
+        {
+            return false;
+        }
+        if (size() - m_pos < len)
+        {
+            m_partial = true;
+            m_pos = pos;
+            return false;
+        }
+        buf = data() + m_pos;
+    }
+    load_fields(buf, args...);
+    m_pos = buf + len - data();
+    return true;
+}
+
+template <typename ...Args>
+bool DataStream::read_schema(std::false_type, Args&... args)
+{
+    int64_t len = sizeof...(Args);
+    int64_t done;
+    if (!enter(DataType::CUSTOM, len, done))
+    {
+        return false;
+    }
+    int index = 0;
+    bool ok = true;
+    int expand[] = { 0, (ok = ok && (index < done || read_field(args)) && ++index, 0)... };
+    (void)expand;
+    return leave(ok, index);
+}
+
+template <typename T, typename ...Args>
+void DataStream::load_fields(const char * buf, T & head, Args&... args)
+{
+    load_field(buf, head);
+    load_fields(buf + sizeof(T), args...);
+}
+
+template <typename T>
+void DataStream::load_field(const char * buf, T & value)
+{
+    std::memcpy(&value, buf, sizeof(T));
+    if (swapped())
+    {
+        value = byteswap(value);
+    }
+}
+
+inline void DataStream::load_field(const char * buf, bool & value)
+{
+    value = buf[0] != 0;
+}
+
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value, bool>::type DataStream::read_field(T & value)
+{
+    if (size() - m_pos < (int)sizeof(T))
+    {
+        m_partial = true;
+        return false;
+    }
+    load_field(data() + m_pos, value);
+    m_pos += sizeof(T);
+    return true;
+}
+
+template<typename Alloc>
+bool DataStream::read_field(std::basic_string<char, std::char_traits<char>, Alloc>& value)
+{
+    StringView view;
+    if (!read_field(view))
+    {
+        return false;
+    }
+    value.assign(view.data(), view.size());
+    return true;
+}
+
+// untagged containers are decoded all or nothing, a short read rewinds
+template<typename T, typename Alloc>
+bool DataStream::read_field(std::vector<T, Alloc>& value)
+{
+    value.clear();
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len) || !read_field_array(value, len, std::integral_constant<bool, ArrayTraits<T>::packed>()))
+    {
+        rewind(pos);
+        return false;
+    }
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_field_array(std::vector<T, Alloc>& value, int64_t len, std::true_type)
+{
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        return false;
+    }
+    value.resize(len);
+    read_array((char *)value.data(), len * sizeof(T), sizeof(T));
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_field_array(std::vector<T, Alloc>& value, int64_t len, std::false_type)
+{
+    value.reserve(std::min(len, size() - m_pos));
+    for (int64_t i = 0; i < len; i++)
+    {
+        value.emplace_back();
+        if (!read_field(value.back()))
+        {
+            value.pop_back();
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_field(std::list<T, Alloc>& value)
+{
+    return read_field_sequence(value, std::false_type());
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_field(std::deque<T, Alloc>& value)
+{
+    return read_field_sequence(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename C>
+bool DataStream::read_field_sequence(C& value, std::true_type)
+{
+    typedef typename C::value_type T;
+    value.clear();
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        rewind(pos);
+        return false;
+    }
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        rewind(pos);
+        return false;
+    }
+    value.resize(len);
+    return read_field_elements(value.begin(), len, std::true_type());
+}
+
+template<typename C>
+bool DataStream::read_field_sequence(C& value, std::false_type)
+{
+    value.clear();
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        rewind(pos);
+        return false;
+    }
+    for (int64_t i = 0; i < len; i++)
+    {
+        value.emplace_back();
+        if (!read_field(value.back()))
+        {
+            value.pop_back();
+            rewind(pos);
+            return false;
+        }
+    }
+    return true;
+}
+
+// an array only takes a sequence of exactly its size
+template<typename T, size_t N>
+bool DataStream::read_field(std::array<T, N>& value)
+{
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        rewind(pos);
+        return false;
+    }
+    if (len != (int)N)
+    {
+        m_partial = false;
+        rewind(pos);
+        return false;
+    }
+    if (!read_field_elements(value.begin(), len, std::integral_constant<bool, ArrayTraits<T>::packed>()))
+    {
+        rewind(pos);
+        return false;
+    }
+    return true;
+}
+
+template<typename Iterator>
+bool DataStream::read_field_elements(Iterator first, int64_t len, std::true_type)
+{
+    typedef typename std::iterator_traits<Iterator>::value_type T;
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        return false;
+    }
+    read_packed(first, len);
+    return true;
+}
+
+template<typename Iterator>
+bool DataStream::read_field_elements(Iterator first, int64_t len, std::false_type)
+{
+    for (int64_t i = 0; i < len; i++)
+    {
+        if (!read_field(*first++))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename A, typename B>
+bool DataStream::read_field(std::pair<A, B>& value)
+{
+    int64_t pos = m_pos;
+    if (!read_field(value.first) || !read_field(value.second))
+    {
+        rewind(pos);
+        return false;
+    }
+    return true;
+}
+
+template<typename ...Args>
+bool DataStream::read_field(std::tuple<Args...>& value)
+{
+    return read_field_tuple(value, typename MakeIndices<sizeof...(Args)>::type());
+}
+
+template<typename Tuple, size_t ...I>
+bool DataStream::read_field_tuple(Tuple& value, Indices<I...>)
+{
+    int64_t pos = m_pos;
+    if (!read_fields(std::get<I>(value)...))
+    {
+        rewind(pos);
+        return false;
+    }
+    return true;
+}
+
+template<typename K, typename V, typename Compare, typename Alloc>
+bool DataStream::read_field(std::map<K, V, Compare, Alloc>& value)
+{
+    return read_field_map(value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+bool DataStream::read_field(std::unordered_map<K, V, Hash, Equal, Alloc>& value)
+{
+    return read_field_map(value);
+}
+
+template<typename M>
+bool DataStream::read_field_map(M& value)
+{
+    value.clear();
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        rewind(pos);
+        return false;
+    }
+    reserve_entries(value, std::min(len, size() - m_pos));
+    for (int64_t i = 0; i < len; i++)
+    {
+        typename M::key_type k;
+        typename M::mapped_type v;
+        if (!read_field(k) || !read_field(v))
+        {
+            rewind(pos);
+            return false;
+        }
+        value.emplace_hint(value.end(), std::move(k), std::move(v));
+    }
+    return true;
+}
+
+template<typename K, typename Compare, typename Alloc>
+bool DataStream::read_field(std::set<K, Compare, Alloc>& value)
+{
+    return read_field_set(value);
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+bool DataStream::read_field(std::unordered_set<K, Hash, Equal, Alloc>& value)
+{
+    return read_field_set(value);
+}
+
+template<typename S>
+bool DataStream::read_field_set(S& value)
+{
+    value.clear();
+    int64_t pos = m_pos;
+    int64_t len;
+    if (!read_length(len))
+    {
+        rewind(pos);
+        return false;
+    }
+    reserve_entries(value, std::min(len, size() - m_pos));
+    for (int64_t i = 0; i < len; i++)
+    {
+        typename S::value_type v;
+        if (!read_field(v))
+        {
+            rewind(pos);
+            return false;
+        }
+        value.emplace_hint(value.end(), std::move(v));
+    }
+    return true;
+}
+
+template<typename Alloc>
+bool DataStream::read(std::basic_string<char, std::char_traits<char>, Alloc>& value)
+{
+    StringView view;
+    if (!read(view))
+    {
+        return false;
+    }
+    value.assign(view.data(), view.size());
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read(std::vector<T, Alloc>& value)
+{
+    return read_vector(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_vector(std::vector<T, Alloc>& value, std::true_type)
+{
+    if (resuming() || peek(DataType::VECTOR))
+    {
+        return read_vector(value, std::false_type());
+    }
+    value.clear();
+    if (size() - m_pos < 2 || data()[m_pos] != DataType::ARRAY || data()[m_pos + 1] != ArrayTraits<T>::type)
+    {
+        m_partial = size() - m_pos < 2 && (m_pos >= size() || data()[m_pos] == DataType::ARRAY);
+        return false;
+    }
+    // a packed block is decoded all or nothing
+    int64_t pos = m_pos;
+    m_pos += 2;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    value.resize(len);
+    read_array((char *)value.data(), len * sizeof(T), sizeof(T));
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_vector(std::vector<T, Alloc>& value, std::false_type)
+{
+    int64_t count = parallel_count(DataType::VECTOR);
+    if (count >= 0)
+    {
+        value.clear();
+        value.resize(count);
+        bool ok = read_chunks(DataType::VECTOR, [&](DataStream & part, int64_t first, int64_t last)
+        {
+            for (int64_t i = first; i < last; i++)
+            {
+                if (!part.read(value[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+        if (!ok)
+        {
+            value.clear();
+        }
+        return ok;
+    }
+    if (!resuming())
+    {
+        value.clear();
+    }
+    int64_t len;
+    int64_t done;
+    if (!enter(DataType::VECTOR, len, done))
+    {
+        return false;
+    }
+    if (done == 0)
+    {
+        value.reserve(std::min(len, size() - m_pos));
+    }
+    // only the first element can be one left half decoded by a partial read
+    bool partial = resuming();
+    for (; done < len; done++, partial = false)
+    {
+        if (!partial)
+        {
+            value.emplace_back();
+        }
+        if (!read(value.back()))
+        {
+            if (!m_partial || !resuming())
+            {
+                value.pop_back();
+            }
+            return leave(false, done);
+        }
+    }
+    return leave(true, done);
+}
+
+template<typename T>
+bool DataStream::read(ArrayView<T>& value)
+{
+    if (size() - m_pos < 2 || data()[m_pos] != DataType::ARRAY || data()[m_pos + 1] != ArrayTraits<T>::type)
+    {
+        m_partial = size() - m_pos < 2 && (m_pos >= size() || data()[m_pos] == DataType::ARRAY);
+        return false;
+    }
+    int64_t pos = m_pos;
+    m_pos += 2;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        return false;
+    }
+    value = ArrayView<T>(data() + m_pos, len, swapped());
+    m_pos += len * sizeof(T);
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read(std::list<T, Alloc>& value)
+{
+    return read_sequence(DataType::LIST, value);
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read(std::deque<T, Alloc>& value)
+{
+    return read_deque(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+// takes what a vector of the same type writes, a block or tagged values
+template<typename T, typename Alloc>
+bool DataStream::read_deque(std::deque<T, Alloc>& value, std::true_type)
+{
+    if (resuming() || peek(DataType::VECTOR))
+    {
+        return read_sequence(DataType::VECTOR, value);
+    }
+    // resized rather than cleared on success, so the deque keeps its blocks
+    if (size() - m_pos < 2 || data()[m_pos] != DataType::ARRAY || data()[m_pos + 1] != ArrayTraits<T>::type)
+    {
+        m_partial = size() - m_pos < 2 && (m_pos >= size() || data()[m_pos] == DataType::ARRAY);
+        value.clear();
+        return false;
+    }
+    int64_t pos = m_pos;
+    m_pos += 2;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        value.clear();
+        return false;
+    }
+    if ((size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = true;
+        m_pos = pos;
+        value.clear();
+        return false;
+    }
+    value.resize(len);
+    read_packed(value.begin(), len);
+    return true;
+}
+
+template<typename T, typename Alloc>
+bool DataStream::read_deque(std::deque<T, Alloc>& value, std::false_type)
+{
+    return read_sequence(DataType::VECTOR, value);
+}
+
+template<typename C>
+bool DataStream::read_sequence(char type, C& value)
+{
+    if (!resuming())
+    {
+        value.clear();
+    }
+    int64_t len;
+    int64_t done;
+    if (!enter(type, len, done))
+    {
+        return false;
+    }
+    // only the first element can be one left half decoded by a partial read
+    bool partial = resuming();
+    for (; done < len; done++, partial = false)
+    {
+        if (!partial)
+        {
+            value.emplace_back();
+        }
+        if (!read(value.back()))
+        {
+            if (!m_partial || !resuming())
+            {
+                value.pop_back();
+            }
+            return leave(false, done);
+        }
+    }
+    return leave(true, done);
+}
+
+template<typename T>
+void DataStream::read_packed(T * first, int64_t len)
+{
+    read_array((char *)first, len * sizeof(T), sizeof(T));
+}
+
+// the caller has checked that the values are there
+template<typename Iterator>
+void DataStream::read_packed(Iterator first, int64_t len)
+{
+    typedef typename std::iterator_traits<Iterator>::value_type T;
+    T buf[4096 / sizeof(T)];
+    while (len > 0)
+    {
+        int n = std::min<int64_t>(len, sizeof(buf) / sizeof(T));
+        read_array((char *)buf, n * sizeof(T), sizeof(T));
+        first = std::copy(buf, buf + n, first);
+        len -= n;
+    }
+}
+
+template<typename T, size_t N>
+bool DataStream::read(std::array<T, N>& value)
+{
+    return read_fixed(value, std::integral_constant<bool, ArrayTraits<T>::packed>());
+}
+
+// a block of exactly N values read straight into the array
+template<typename T, size_t N>
+bool DataStream::read_fixed(std::array<T, N>& value, std::true_type)
+{
+    if (resuming() || peek(DataType::VECTOR))
+    {
+        return read_fixed(value, std::false_type());
+    }
+    if (size() - m_pos < 2 || data()[m_pos] != DataType::ARRAY || data()[m_pos + 1] != ArrayTraits<T>::type)
+    {
+        m_partial = size() - m_pos < 2 && (m_pos >= size() || data()[m_pos] == DataType::ARRAY);
+        return false;
+    }
+    int64_t pos = m_pos;
+    m_pos += 2;
+    int64_t len;
+    if (!read_length(len))
+    {
+        m_pos = pos;
+        return false;
+    }
+    if (len != (int)N || (size() - m_pos) / (int)sizeof(T) < len)
+    {
+        m_partial = len == (int)N;
+        m_pos = pos;
+        return false;
+    }
+    read_packed(value.data(), len);
+    return true;
+}
+
+template<typename T, size_t N>
+bool DataStream::read_fixed(std::array<T, N>& value, std::false_type)
+{
+    int64_t len;
+    int64_t done;
+    if (!enter(DataType::VECTOR, len, done))
+    {
+        return false;
+    }
+    if (len != (int)N)
+    {
+        m_partial = false;
+        return leave(false, done);
+    }
+    // elements are decoded in place, so a partial one resumes where it is
+    for (; done < len; done++)
+    {
+        if (!read(value[done]))
+        {
+            return leave(false, done);
+        }
+    }
+    return leave(true, done);
+}
+
+template<typename A, typename B>
+bool DataStream::read(std::pair<A, B>& value)
+{
+    return read_object(value.first, value.second);
+}
+
+template<typename ...Args>
+bool DataStream::read(std::tuple<Args...>& value)
+{
+    return read_tuple(value, typename MakeIndices<sizeof...(Args)>::type());
+}
+
+template<typename Tuple, size_t ...I>
+bool DataStream::read_tuple(Tuple& value, Indices<I...>)
+{
+    return read_object(std::get<I>(value)...);
+}
+
+template<typename K, typename V, typename Compare, typename Alloc>
+bool DataStream::read(std::map<K, V, Compare, Alloc>& value)
+{
+    return read_map(value);
+}
+
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+bool DataStream::read(std::unordered_map<K, V, Hash, Equal, Alloc>& value)
+{
+    return read_map(value);
+}
+
+template<typename M>
+bool DataStream::read_map(M& value)
+{
+    typedef typename M::key_type K;
+    typedef typename M::mapped_type V;
+    // the entries are decoded in parallel and inserted in order afterwards
+    int64_t count = parallel_count(DataType::MAP);
+    if (count >= 0)
+    {
+        std::vector<std::pair<K, V>> entries(count);
+        bool ok = read_chunks(DataType::MAP, [&](DataStream & part, int64_t first, int64_t last)
+        {
+            for (int64_t i = first; i < last; i++)
+            {
+                if (!part.read(entries[i].first) || !part.read(entries[i].second))
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+        value.clear();
+        reserve_entries(value, ok ? count : 0);
+        for (int64_t i = 0; ok && i < count; i++)
+        {
+            auto & entry = entries[i];
+            value.emplace_hint(value.end(), std::move(entry.first), std::move(entry.second));
+        }
+        return ok;
+    }
+    if (!resuming())
+    {
+        value.clear();
+    }
+    int64_t len;
+    int64_t done;
+    if (!enter(DataType::MAP, len, done))
+    {
+        return false;
+    }
+    if (done == 0)
+    {
+        reserve_entries(value, std::min(len, size() - m_pos));
+    }
+    for (; done < len; done++)
+    {
+        // an entry is only inserted whole, a short read restarts it
+        int64_t pos = m_pos;
+        K k;
+        V v;
+        if (!read(k) || !read(v))
+        {
+            rewind(pos);
+            return leave(false, done);
+        }
+        value.emplace_hint(value.end(), std::move(k), std::move(v));
+    }
+    return leave(true, done);
+}
+
+template<typename K, typename Compare, typename Alloc>
+bool DataStream::read(std::set<K, Compare, Alloc>& value)
+{
+    return read_set(value);
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+bool DataStream::read(std::unordered_set<K, Hash, Equal, Alloc>& value)
+{
+    return read_set(value);
+}
+
+template<typename S>
+bool DataStream::read_set(S& value)
+{
+    typedef typename S::value_type K;
+    int64_t count = parallel_count(DataType::SET);
+    if (count >= 0)
+    {
+        std::vector<K> entries(count);
+        bool ok = read_chunks(DataType::SET, [&](DataStream & part, int64_t first, int64_t last)
+        {
+            for (int64_t i = first; i < last; i++)
+            {
+                if (!part.read(entries[i]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        });
+        value.clear();
+        reserve_entries(value, ok ? count : 0);
+        for (int64_t i = 0; ok && i < count; i++)
+        {
+            auto & entry = entries[i];
+            value.emplace_hint(value.end(), std::move(entry));
+        }
+        return ok;
+    }
+    if (!resuming())
+    {
+        value.clear();
+    }
+    int64_t len;
+    int64_t done;
+    if (!enter(DataType::SET, len, done))
+    {
+        return false;
+    }
+    if (done == 0)
+    {
+        reserve_entries(value, std::min(len, size() - m_pos));
+    }
+    for (; done < len; done++)
+    {
+        int64_t pos = m_pos;
+        K v;
+        if (!read(v))
+        {
+            rewind(pos);
+            return leave(false, done);
+        }
+        value.emplace_hint(value.end(), std::move(v));
+    }
+    return leave(true, done);
+}
+
+template <typename T, typename ...Args>
+bool DataStream::DataStream::read_args(T & head, Args&... args)
+{
+    return read(head) && read_args(args...);
+}
+
+template<typename T>
+typename std::enable_if<Reflect<T>::value, DataStream &>::type DataStream::operator << (const T & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename Alloc>
+DataStream & DataStream::operator << (const std::basic_string<char, std::char_traits<char>, Alloc> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T>
+DataStream & DataStream::operator << (const ArrayView<T> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T, typename Alloc>
+DataStream & DataStream::operator << (const std::vector<T, Alloc> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T, typename Alloc>
+DataStream & DataStream::operator << (const std::list<T, Alloc> & value) {
     write(value);
     return *this;
 }
@@ -336,6 +2862,69 @@ DataStream & DataStream::operator << (const std::set<K, Compare, Alloc> & value)
     return *this;
 }
 
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+DataStream & DataStream::operator << (const std::unordered_map<K, V, Hash, Equal, Alloc> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+DataStream & DataStream::operator << (const std::unordered_set<K, Hash, Equal, Alloc> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T, typename Alloc>
+DataStream & DataStream::operator << (const std::deque<T, Alloc> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T, size_t N>
+DataStream & DataStream::operator << (const std::array<T, N> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename A, typename B>
+DataStream & DataStream::operator << (const std::pair<A, B> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename ...Args>
+DataStream & DataStream::operator << (const std::tuple<Args...> & value)
+{
+    write(value);
+    return *this;
+}
+
+template<typename T>
+typename std::enable_if<Reflect<T>::value, DataStream &>::type DataStream::operator >> (T & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename Alloc>
+DataStream & DataStream::operator >> (std::basic_string<char, std::char_traits<char>, Alloc> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename T>
+DataStream & DataStream::operator >> (ArrayView<T> & value)
+{
+    read(value);
+    return *this;
+}
+
 template<typename T, typename Alloc>
 DataStream & DataStream::operator >> (std::vector<T, Alloc> & value)
 {
@@ -364,5 +2953,47 @@ DataStream & DataStream::operator >> (std::set<K, Compare, Alloc> & value)
     return *this;
 }
 
+template<typename K, typename V, typename Hash, typename Equal, typename Alloc>
+DataStream & DataStream::operator >> (std::unordered_map<K, V, Hash, Equal, Alloc> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename K, typename Hash, typename Equal, typename Alloc>
+DataStream & DataStream::operator >> (std::unordered_set<K, Hash, Equal, Alloc> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename T, typename Alloc>
+DataStream & DataStream::operator >> (std::deque<T, Alloc> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename T, size_t N>
+DataStream & DataStream::operator >> (std::array<T, N> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename A, typename B>
+DataStream & DataStream::operator >> (std::pair<A, B> & value)
+{
+    read(value);
+    return *this;
+}
+
+template<typename ...Args>
+DataStream & DataStream::operator >> (std::tuple<Args...> & value)
+{
+    read(value);
+    return *this;
+}
+
 }
 }
\ No newline at end of file
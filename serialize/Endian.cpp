@@ -0,0 +1,162 @@
+#include <serialize/Endian.h>
+#include <algorithm>
+using namespace yazi::serialize;
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SWAP_X86 1
+#endif
+
+template <typename T>
+static void swap_words(char * dst, const char * src, int64_t len)
+{
+    for (int64_t i = 0; i + (int64_t)sizeof(T) <= len; i += sizeof(T))
+    {
+        T word;
+        std::memcpy(&word, src + i, sizeof(T));
+        word = byteswap(word);
+        std::memcpy(dst + i, &word, sizeof(T));
+    }
+}
+
+static void swap_scalar(char * dst, const char * src, int64_t len, int width)
+{
+    switch (width)
+    {
+    case 2:
+        swap_words<uint16_t>(dst, src, len);
+        break;
+    case 4:
+        swap_words<uint32_t>(dst, src, len);
+        break;
+    case 8:
+        swap_words<uint64_t>(dst, src, len);
+        break;
+    default:
+        if (dst != src)
+        {
+            std::memmove(dst, src, len);
+        }
+        if (width > 1)
+        {
+            for (char * first = dst; first + width <= dst + len; first += width)
+            {
+                std::reverse(first, first + width);
+            }
+        }
+        break;
+    }
+}
+
+#ifdef SWAP_X86
+
+// pshufb masks reversing every 2, 4 and 8 bytes of a 16 byte lane
+alignas(16) static const char kSwapMask[3][16] = {
+    { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+    { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+    { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 },
+};
+
+static int mask_index(int width)
+{
+    return width == 2 ? 0 : (width == 4 ? 1 : 2);
+}
+
+__attribute__((target("ssse3")))
+static void swap_ssse3(char * dst, const char * src, int64_t len, int width)
+{
+    __m128i mask = _mm_load_si128((const __m128i *)kSwapMask[mask_index(width)]);
+    int64_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, mask));
+    }
+    swap_scalar(dst + i, src + i, len - i, width);
+}
+
+// vpshufb shuffles within each 128 bit lane, which is enough since no value
+// is wider than 8 bytes
+__attribute__((target("avx2")))
+static void swap_avx2(char * dst, const char * src, int64_t len, int width)
+{
+    __m256i mask = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i *)kSwapMask[mask_index(width)]));
+    int64_t i = 0;
+    for (; i + 64 <= len; i += 64)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(a, mask));
+        _mm256_storeu_si256((__m256i *)(dst + i + 32), _mm256_shuffle_epi8(b, mask));
+    }
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(a, mask));
+    }
+    swap_scalar(dst + i, src + i, len - i, width);
+}
+
+#endif
+
+static SwapKernel best_kernel()
+{
+#ifdef SWAP_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return Avx2Swap;
+    }
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        return Ssse3Swap;
+    }
+#endif
+    return ScalarSwap;
+}
+
+static SwapKernel & current_kernel()
+{
+    static SwapKernel kernel = best_kernel();
+    return kernel;
+}
+
+SwapKernel yazi::serialize::swap_kernel()
+{
+    return current_kernel();
+}
+
+bool yazi::serialize::set_swap_kernel(SwapKernel kernel)
+{
+    static const SwapKernel best = best_kernel();
+    if (kernel > best)
+    {
+        return false;
+    }
+    current_kernel() = kernel;
+    return true;
+}
+
+void yazi::serialize::swap_bytes(char * dst, const char * src, int64_t len, int width)
+{
+    // below one vector, or for odd widths, the vector kernels gain nothing
+    if (len < 16 || (width != 2 && width != 4 && width != 8))
+    {
+        swap_scalar(dst, src, len, width);
+        return;
+    }
+    switch (current_kernel())
+    {
+#ifdef SWAP_X86
+    case Avx2Swap:
+        swap_avx2(dst, src, len, width);
+        break;
+    case Ssse3Swap:
+        swap_ssse3(dst, src, len, width);
+        break;
+#endif
+    default:
+        swap_scalar(dst, src, len, width);
+        break;
+    }
+}
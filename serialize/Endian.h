@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace yazi {
+namespace serialize {
+
+// host byte order, fixed at compile time
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+static const bool kHostBigEndian = true;
+#else
+static const bool kHostBigEndian = false;
+#endif
+
+template <int N>
+struct SwapWord;
+
+template <>
+struct SwapWord<1>
+{
+    typedef uint8_t type;
+    static uint8_t swap(uint8_t word) { return word; }
+};
+
+template <>
+struct SwapWord<2>
+{
+    typedef uint16_t type;
+    static uint16_t swap(uint16_t word) { return __builtin_bswap16(word); }
+};
+
+template <>
+struct SwapWord<4>
+{
+    typedef uint32_t type;
+    static uint32_t swap(uint32_t word) { return __builtin_bswap32(word); }
+};
+
+template <>
+struct SwapWord<8>
+{
+    typedef uint64_t type;
+    static uint64_t swap(uint64_t word) { return __builtin_bswap64(word); }
+};
+
+// reverses the bytes of one arithmetic value, floats go through an integer
+template <typename T>
+inline T byteswap(T value)
+{
+    typename SwapWord<sizeof(T)>::type word;
+    std::memcpy(&word, &value, sizeof(T));
+    word = SwapWord<sizeof(T)>::swap(word);
+    std::memcpy(&value, &word, sizeof(T));
+    return value;
+}
+
+// the kernel swap_bytes uses, picked from the cpu on first use
+enum SwapKernel
+{
+    ScalarSwap,
+    Ssse3Swap,
+    Avx2Swap
+};
+
+SwapKernel swap_kernel();
+
+// forces a kernel, false if the cpu does not support it
+bool set_swap_kernel(SwapKernel kernel);
+
+// copies len bytes of width-byte values from src to dst reversing each value,
+// dst may be the same as src
+void swap_bytes(char * dst, const char * src, int64_t len, int width);
+
+}
+}
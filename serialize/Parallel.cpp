@@ -0,0 +1,166 @@
+#include <serialize/Parallel.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace yazi::serialize;
+
+namespace {
+
+// the tasks of one parallel_for, taken in turn by whichever thread is free
+class Job
+{
+public:
+    Job(int tasks, const std::function<void(int)> & task) : m_tasks(tasks), m_task(task), m_next(0)
+    {
+    }
+
+    void work()
+    {
+        for (int i = m_next++; i < m_tasks; i = m_next++)
+        {
+            try
+            {
+                m_task(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_error)
+                {
+                    m_error = std::current_exception();
+                }
+            }
+        }
+    }
+
+    void finish()
+    {
+        if (m_error)
+        {
+            std::rethrow_exception(m_error);
+        }
+    }
+
+private:
+    int m_tasks;
+    const std::function<void(int)> & m_task;
+    std::atomic<int> m_next;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+};
+
+// helper threads started as they are first needed and kept for the life of
+// the process, so a call pays a wake-up instead of a thread start; they run
+// one job at a time, and a call made while they are busy (from another
+// thread, or from inside a task) is told to start threads of its own
+class Pool
+{
+public:
+    static Pool & instance()
+    {
+        // never destroyed, helpers may still be waiting when the process exits
+        static Pool * pool = new Pool();
+        return *pool;
+    }
+
+    bool run(Job & job, int helpers)
+    {
+        bool idle = false;
+        if (!m_busy.compare_exchange_strong(idle, true))
+        {
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (; m_threads < helpers; m_threads++)
+            {
+                std::thread(&Pool::loop, this).detach();
+            }
+            m_job = &job;
+            m_wanted = helpers;
+            m_claimed = 0;
+            m_finished = 0;
+            m_generation++;
+        }
+        m_wake.notify_all();
+        job.work();
+        // no helper may join once the caller is done, then wait for the
+        // ones that did
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job = NULL;
+        m_done.wait(lock, [this]() { return m_finished == m_claimed; });
+        lock.unlock();
+        m_busy = false;
+        return true;
+    }
+
+private:
+    Pool() : m_busy(false), m_threads(0), m_job(NULL), m_wanted(0), m_claimed(0), m_finished(0), m_generation(0)
+    {
+    }
+
+    void loop()
+    {
+        int64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (true)
+        {
+            m_wake.wait(lock, [&]() { return m_job != NULL && m_generation != seen && m_claimed < m_wanted; });
+            seen = m_generation;
+            Job * job = m_job;
+            m_claimed++;
+            lock.unlock();
+            job->work();
+            lock.lock();
+            if (++m_finished == m_claimed)
+            {
+                m_done.notify_all();
+            }
+        }
+    }
+
+private:
+    std::atomic<bool> m_busy;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    int m_threads;
+    Job * m_job;
+    int m_wanted;
+    int m_claimed;
+    int m_finished;
+    int64_t m_generation;
+};
+
+}
+
+void yazi::serialize::parallel_for(int tasks, int threads, const std::function<void(int)> & task)
+{
+    Job job(tasks, task);
+    int helpers = std::min(threads, tasks) - 1;
+    if (helpers <= 0)
+    {
+        job.work();
+        job.finish();
+        return;
+    }
+    if (!Pool::instance().run(job, helpers))
+    {
+        std::vector<std::thread> workers;
+        for (int i = 0; i < helpers; i++)
+        {
+            workers.emplace_back(&Job::work, &job);
+        }
+        job.work();
+        for (auto & worker : workers)
+        {
+            worker.join();
+        }
+    }
+    job.finish();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <functional>
+
+namespace yazi {
+namespace serialize {
+
+// runs task(0) .. task(tasks - 1) on up to threads threads, the calling one
+// included, the others from a pool kept between calls; the first exception
+// a task throws is rethrown here
+void parallel_for(int tasks, int threads, const std::function<void(int)> & task);
+
+}
+}
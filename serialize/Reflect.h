@@ -0,0 +1,109 @@
+#pragma once
+
+namespace yazi {
+namespace serialize {
+
+// compile time field lists for plain structs, the non-virtual counterpart of
+// Serializable: nothing is added to the struct and nested objects inline
+//
+//   struct Point { int32_t x; int32_t y; };
+//   REFLECT(Point, x, y)
+//
+// REFLECT writes the same bytes as SERIALIZE and REFLECT_SCHEMA the same as
+// SERIALIZE_SCHEMA; both are used at global scope, after the struct
+template <typename T>
+struct Reflect
+{
+    static const bool value = false;
+};
+
+}
+}
+
+#define REFLECT_EXPAND(x) x
+#define REFLECT_CONCAT_(a, b) a##b
+#define REFLECT_CONCAT(a, b) REFLECT_CONCAT_(a, b)
+
+#define REFLECT_COUNT(...) REFLECT_EXPAND(REFLECT_COUNT_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define REFLECT_COUNT_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+
+// value.a, value.b, ... for up to 32 fields
+#define REFLECT_FIELDS(value, ...) REFLECT_EXPAND(REFLECT_CONCAT(REFLECT_FIELDS_, REFLECT_COUNT(__VA_ARGS__))(value, __VA_ARGS__))
+#define REFLECT_FIELDS_1(v, a) v.a
+#define REFLECT_FIELDS_2(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_1(v, __VA_ARGS__))
+#define REFLECT_FIELDS_3(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_2(v, __VA_ARGS__))
+#define REFLECT_FIELDS_4(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_3(v, __VA_ARGS__))
+#define REFLECT_FIELDS_5(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_4(v, __VA_ARGS__))
+#define REFLECT_FIELDS_6(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_5(v, __VA_ARGS__))
+#define REFLECT_FIELDS_7(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_6(v, __VA_ARGS__))
+#define REFLECT_FIELDS_8(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_7(v, __VA_ARGS__))
+#define REFLECT_FIELDS_9(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_8(v, __VA_ARGS__))
+#define REFLECT_FIELDS_10(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_9(v, __VA_ARGS__))
+#define REFLECT_FIELDS_11(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_10(v, __VA_ARGS__))
+#define REFLECT_FIELDS_12(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_11(v, __VA_ARGS__))
+#define REFLECT_FIELDS_13(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_12(v, __VA_ARGS__))
+#define REFLECT_FIELDS_14(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_13(v, __VA_ARGS__))
+#define REFLECT_FIELDS_15(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_14(v, __VA_ARGS__))
+#define REFLECT_FIELDS_16(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_15(v, __VA_ARGS__))
+#define REFLECT_FIELDS_17(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_16(v, __VA_ARGS__))
+#define REFLECT_FIELDS_18(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_17(v, __VA_ARGS__))
+#define REFLECT_FIELDS_19(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_18(v, __VA_ARGS__))
+#define REFLECT_FIELDS_20(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_19(v, __VA_ARGS__))
+#define REFLECT_FIELDS_21(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_20(v, __VA_ARGS__))
+#define REFLECT_FIELDS_22(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_21(v, __VA_ARGS__))
+#define REFLECT_FIELDS_23(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_22(v, __VA_ARGS__))
+#define REFLECT_FIELDS_24(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_23(v, __VA_ARGS__))
+#define REFLECT_FIELDS_25(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_24(v, __VA_ARGS__))
+#define REFLECT_FIELDS_26(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_25(v, __VA_ARGS__))
+#define REFLECT_FIELDS_27(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_26(v, __VA_ARGS__))
+#define REFLECT_FIELDS_28(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_27(v, __VA_ARGS__))
+#define REFLECT_FIELDS_29(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_28(v, __VA_ARGS__))
+#define REFLECT_FIELDS_30(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_29(v, __VA_ARGS__))
+#define REFLECT_FIELDS_31(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_30(v, __VA_ARGS__))
+#define REFLECT_FIELDS_32(v, a, ...) v.a, REFLECT_EXPAND(REFLECT_FIELDS_31(v, __VA_ARGS__))
+
+#define REFLECT(Type, ...)                                                    \
+    namespace yazi {                                                          \
+    namespace serialize {                                                     \
+    template <>                                                               \
+    struct Reflect<Type>                                                      \
+    {                                                                         \
+        static const bool value = true;                                       \
+                                                                              \
+        template <typename Stream>                                            \
+        static void write(Stream & stream, const Type & value)                \
+        {                                                                     \
+            stream.write_object(REFLECT_FIELDS(value, __VA_ARGS__));          \
+        }                                                                     \
+                                                                              \
+        template <typename Stream>                                            \
+        static bool read(Stream & stream, Type & value)                       \
+        {                                                                     \
+            return stream.read_object(REFLECT_FIELDS(value, __VA_ARGS__));    \
+        }                                                                     \
+    };                                                                        \
+    }                                                                         \
+    }
+
+#define REFLECT_SCHEMA(Type, ...)                                             \
+    namespace yazi {                                                          \
+    namespace serialize {                                                     \
+    template <>                                                               \
+    struct Reflect<Type>                                                      \
+    {                                                                         \
+        static const bool value = true;                                       \
+                                                                              \
+        template <typename Stream>                                            \
+        static void write(Stream & stream, const Type & value)                \
+        {                                                                     \
+            stream.write_schema(REFLECT_FIELDS(value, __VA_ARGS__));          \
+        }                                                                     \
+                                                                              \
+        template <typename Stream>                                            \
+        static bool read(Stream & stream, Type & value)                       \
+        {                                                                     \
+            return stream.read_schema(REFLECT_FIELDS(value, __VA_ARGS__));    \
+        }                                                                     \
+    };                                                                        \
+    }                                                                         \
+    }
@@ -15,21 +15,25 @@ public:
 #define SERIALIZE(...)                              \
     void serialize(DataStream & stream) const       \
     {                                               \
-        char type = DataStream::CUSTOM;             \
-        stream.write((char *)&type, sizeof(char));  \
-        stream.write_args(__VA_ARGS__);             \
+        stream.write_object(__VA_ARGS__);           \
     }                                               \
                                                     \
     bool unserialize(DataStream & stream)           \
     {                                               \
-        char type;                                  \
-        stream.read(&type, sizeof(char));           \
-        if (type != DataStream::CUSTOM)             \
-        {                                           \
-            return false;                           \
-        }                                           \
-        stream.read_args(__VA_ARGS__);              \
-        return true;                                \
+        return stream.read_object(__VA_ARGS__);     \
+    }
+
+// like SERIALIZE, but the fields carry no type tags; both sides must agree on
+// the field list, and a struct of arithmetic fields is stored in one block
+#define SERIALIZE_SCHEMA(...)                       \
+    void serialize(DataStream & stream) const       \
+    {                                               \
+        stream.write_schema(__VA_ARGS__);           \
+    }                                               \
+                                                    \
+    bool unserialize(DataStream & stream)           \
+    {                                               \
+        return stream.read_schema(__VA_ARGS__);     \
     }
 
 }
@@ -0,0 +1,101 @@
+#include <serialize/Sink.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+using namespace yazi::serialize;
+
+// writes to a file opened for appending land at the end whatever offset
+// they ask for, so such a file is not patched even though it can seek
+static bool appending(int fd)
+{
+    int flags = ::fcntl(fd, F_GETFL);
+    return flags >= 0 && (flags & O_APPEND) != 0;
+}
+
+FdSink::FdSink(int fd) : m_fd(fd)
+{
+    m_base = appending(fd) ? -1 : ::lseek(fd, 0, SEEK_CUR);
+}
+
+bool FdSink::write(const char * data, int len)
+{
+    while (len > 0)
+    {
+        ssize_t n = ::write(m_fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+bool FdSink::seekable() const
+{
+    return m_base >= 0;
+}
+
+bool FdSink::patch(int64_t offset, const char * data, int len)
+{
+    if (m_base < 0)
+    {
+        return false;
+    }
+    while (len > 0)
+    {
+        ssize_t n = ::pwrite(m_fd, data, len, m_base + offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= n;
+        offset += n;
+    }
+    return true;
+}
+
+FileSink::FileSink(FILE * fp) : m_fp(fp)
+{
+    m_base = appending(::fileno(fp)) ? -1 : ::ftello(fp);
+}
+
+bool FileSink::write(const char * data, int len)
+{
+    return std::fwrite(data, 1, len, m_fp) == (size_t)len;
+}
+
+bool FileSink::seekable() const
+{
+    return m_base >= 0;
+}
+
+bool FileSink::patch(int64_t offset, const char * data, int len)
+{
+    off_t pos = ::ftello(m_fp);
+    if (m_base < 0 || pos < 0 || ::fseeko(m_fp, m_base + offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    bool ok = std::fwrite(data, 1, len, m_fp) == (size_t)len;
+    return ::fseeko(m_fp, pos, SEEK_SET) == 0 && ok;
+}
+
+CallbackSink::CallbackSink(const std::function<bool(const char *, int)> & callback) : m_callback(callback)
+{
+}
+
+bool CallbackSink::write(const char * data, int len)
+{
+    return m_callback(data, len);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+
+namespace yazi {
+namespace serialize {
+
+// destination for a streaming DataStream, offsets are relative to the first
+// byte the sink received
+class Sink
+{
+public:
+    virtual ~Sink() {}
+
+    virtual bool write(const char * data, int len) = 0;
+
+    // sinks that can rewrite earlier bytes let containers of unknown length
+    // be backpatched instead of held back in memory
+    virtual bool seekable() const { return false; }
+    virtual bool patch(int64_t offset, const char * data, int len) { return false; }
+};
+
+class FdSink : public Sink
+{
+public:
+    FdSink(int fd);
+
+    virtual bool write(const char * data, int len);
+    virtual bool seekable() const;
+    virtual bool patch(int64_t offset, const char * data, int len);
+
+private:
+    int m_fd;
+    int64_t m_base;
+};
+
+class FileSink : public Sink
+{
+public:
+    FileSink(FILE * fp);
+
+    virtual bool write(const char * data, int len);
+    virtual bool seekable() const;
+    virtual bool patch(int64_t offset, const char * data, int len);
+
+private:
+    FILE * m_fp;
+    int64_t m_base;
+};
+
+class CallbackSink : public Sink
+{
+public:
+    CallbackSink(const std::function<bool(const char *, int)> & callback);
+
+    virtual bool write(const char * data, int len);
+
+private:
+    std::function<bool(const char *, int)> m_callback;
+};
+
+}
+}
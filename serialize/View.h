@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+#include <serialize/Endian.h>
+
+namespace yazi {
+namespace serialize {
+
+// non-owning reference to bytes that live in a buffer owned by someone else
+class StringView
+{
+public:
+    StringView() : m_data(NULL), m_size(0) {}
+    StringView(const char * data, int64_t size) : m_data(data), m_size(size) {}
+    StringView(const char * data) : m_data(data), m_size(strlen(data)) {}
+    StringView(const std::string & str) : m_data(str.data()), m_size(str.size()) {}
+
+    const char * data() const { return m_data; }
+    int64_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const char * begin() const { return m_data; }
+    const char * end() const { return m_data + m_size; }
+    char operator [] (int64_t i) const { return m_data[i]; }
+    std::string str() const { return std::string(m_data, m_size); }
+
+    bool operator == (const StringView & other) const
+    {
+        return m_size == other.m_size && std::memcmp(m_data, other.m_data, m_size) == 0;
+    }
+
+    bool operator != (const StringView & other) const
+    {
+        return !(*this == other);
+    }
+
+private:
+    const char * m_data;
+    int64_t m_size;
+};
+
+// non-owning view of a packed ARRAY payload, elements are stored in wire byte order
+template <typename T>
+class ArrayView
+{
+public:
+    ArrayView() : m_data(NULL), m_size(0), m_swap(false) {}
+    ArrayView(const char * data, int64_t size, bool swap) : m_data(data), m_size(size), m_swap(swap) {}
+
+    const char * bytes() const { return m_data; }
+    int64_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T operator [] (int64_t i) const
+    {
+        T value;
+        std::memcpy(&value, m_data + i * sizeof(T), sizeof(T));
+        if (m_swap)
+        {
+            value = byteswap(value);
+        }
+        return value;
+    }
+
+private:
+    const char * m_data;
+    int64_t m_size;
+    bool m_swap;
+};
+
+}
+}